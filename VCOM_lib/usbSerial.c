@@ -65,6 +65,8 @@ void VCOM_gets_echo(char *str); // gets string terminated in '\r' or '\n' and ec
 */
 
 #include "usbSerial.h"
+#include "fastcode.h"
+#include "profile.h"
 
 
 
@@ -211,7 +213,7 @@ static const U8 abDescriptors[] = {
 	@param [in] bEP
 	@param [in] bEPStatus
  */
-static void BulkOut(U8 bEP, U8 bEPStatus)
+FASTCODE static void BulkOut(U8 bEP, U8 bEPStatus)
 {
 	int iLen;
 	bEPStatus = bEPStatus;
@@ -245,7 +247,7 @@ static void BulkOut(U8 bEP, U8 bEPStatus)
 	@param [in] bEP
 	@param [in] bEPStatus
  */
-static void BulkIn(U8 bEP, U8 bEPStatus)
+FASTCODE static void BulkIn(U8 bEP, U8 bEPStatus)
 {
 	int i, iLen;
 	bEPStatus = bEPStatus;
@@ -360,6 +362,7 @@ int VCOM_getchar(void)
 //void USBIntHandler(void)
 extern "C" void USB_IRQHandler(void)
 {
+	PROFILE(PROFILE_USB_ISR);
 	USBHwISR();
 }
 
@@ -37,6 +37,7 @@
 #include "usbdebug.h"
 #include "usbhw_lpc.h"
 #include "usbapi.h"
+#include "fastcode.h"
 //  Configure LED pin functions
 //
 //  LED pin functions
@@ -349,7 +350,7 @@ void USBHwEPStall(U8 bEP, BOOL fStall)
 			
 	@return TRUE if the data was successfully written or <0 in case of error.
 */
-int USBHwEPWrite(U8 bEP, U8 *pbBuf, int iLen)
+FASTCODE int USBHwEPWrite(U8 bEP, U8 *pbBuf, int iLen)
 {
 	int idx;
 	
@@ -385,7 +386,7 @@ int USBHwEPWrite(U8 bEP, U8 *pbBuf, int iLen)
 	@return the number of bytes available in the EP (possibly more than iMaxLen),
 	or <0 in case of error.
  */
-int USBHwEPRead(U8 bEP, U8 *pbBuf, int iMaxLen)
+FASTCODE int USBHwEPRead(U8 bEP, U8 *pbBuf, int iMaxLen)
 {
 	int i, idx;
 	U32	dwData, dwLen;
@@ -453,7 +454,7 @@ void USBHwConfigDevice(BOOL fConfigured)
 
 	Endpoint interrupts are mapped to the slow interrupt
  */
-void USBHwISR(void)
+FASTCODE void USBHwISR(void)
 {
 	U32	dwStatus;
 	U32 dwIntBit;
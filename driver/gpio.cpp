@@ -21,6 +21,7 @@
 #include <gpio.h>
 
 #include "LPC17xx.h"
+#include "fastcode.h"
 
 #define LPC_GPIO(port)            ((LPC_GPIO_TypeDef *)(LPC_GPIO0_BASE + (0x00020 * port)))
 
@@ -106,7 +107,8 @@ Pin::operator uint32_t() const {
 
 namespace Detail {
 
-void Bus::write(uint32_t value) const {
+// Kept in RAM for the stepper ISR, which writes through RAM copies of its buses.
+FASTCODE void Bus::write(uint32_t value) const {
     // Naive non-atomic implementation 
     // uint32_t temp = gpio_port_0 | (mask & value);
     // gpio_port_0 = temp & (~mask | value);
@@ -162,6 +162,16 @@ namespace Detail {
          */
         const Bus& operator=(uint32_t value) const;
     };
+
+    /**
+     * @brief Returns a bus of a single pin. Allows keeping a copy of a
+     * constexpr pin definition in RAM for time-critical code.
+     * @param pin Pin instance
+     * @return Bus of the pin
+     */
+    constexpr Bus to_bus(const Pin& pin) {
+        return Bus{pin.port, pin.mask, pin.config.inverted ? pin.mask : 0};
+    }
 }
 
 template<std::size_t N>
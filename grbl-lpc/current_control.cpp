@@ -50,13 +50,21 @@ void current_init()
         ;
 #endif
 
-    set_current(0, settings.current[0]);
-    set_current(1, settings.current[1]);
-    set_current(2, settings.current[2]);
-    set_current(3, settings.current[3]);
+    for (uint8_t motor = 0; motor < board::N_MOTORS; motor++) {
+        set_current(motor, settings.current[board::motors[motor].axis]);
+    }
 #endif
 }
 
+void set_axis_current(uint8_t axis, float amps)
+{
+    for (uint8_t motor = 0; motor < board::N_MOTORS; motor++) {
+        if (board::motors[motor].axis == axis) {
+            set_current(motor, amps);
+        }
+    }
+}
+
 void set_current(uint8_t motor, float amps)
 {
 #if defined(CURRENT_I2C) && defined(CURRENT_MCP44XX_ADDR)
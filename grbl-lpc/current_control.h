@@ -24,3 +24,4 @@
 
 void current_init();
 void set_current(uint8_t motor, float amps);
+void set_axis_current(uint8_t axis, float amps); // Sets all motors of the axis
@@ -0,0 +1,6 @@
+#pragma once
+
+// Places a function in the .fastcode section, which is copied to RAM at startup (see grbl.ld). RAM
+// functions run without flash wait states and keep running while flash is erased or written. Code
+// and data they use while flash is busy, including constants and called functions, must be in RAM too.
+#define FASTCODE __attribute__((section(".fastcode")))
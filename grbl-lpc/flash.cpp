@@ -20,47 +20,291 @@
 
 #include "grbl.h"
 
-static constexpr unsigned flash_sector = 15;                      // Last 4k sector
-static constexpr unsigned flash_addr = 0xF000;                    // Last 4k sector
-static constexpr unsigned flash_size = 1024;                      // Only using 1k of a 4k sector
-static char *flash_memory = (char *)flash_addr;                   // Flash memory
-static char flash_buffer[flash_size] __attribute__((aligned(4))); // Copy of flash memory
+// Flash is memory-mapped from address 0. The host test maps it onto a simulated flash instead.
+#ifndef FLASH_MEMORY
+#define FLASH_MEMORY(addr) ((const char *)(uintptr_t)(addr))
+#endif
+
+static constexpr unsigned flash_size = 1024;                      // Size of the emulated EEPROM
+static char flash_buffer[flash_size] __attribute__((aligned(4))); // EEPROM contents. Committed to the log.
+static constexpr unsigned legacy_addr = 0xF000;                   // Last 4k sector. Whole-image store of
+static const char *legacy_memory = FLASH_MEMORY(legacy_addr);     //   older builds. Imported if no log.
+static constexpr unsigned log_first_sector = 11;                  // 4k sectors below the legacy sector
+static constexpr unsigned log_sectors = 4;
+static constexpr unsigned log_addr = 0xB000;
+static constexpr unsigned log_sector_size = 0x1000;
+static constexpr unsigned log_page_size = 256;                    // Smallest flash write
+static constexpr unsigned log_sector_pages = log_sector_size / log_page_size;
+static constexpr unsigned log_page_data = 244;
+static constexpr uint8_t log_commit_end = 0x01;                   // Last page of a commit
+static constexpr uint8_t log_snapshot = 0x02;                     // Commit holds the whole image
+static constexpr unsigned program_first_sector = 26;              // Last four 32k sectors. Reserved in grbl.ld.
+static constexpr unsigned program_last_sector = 29;
+static constexpr unsigned program_addr = 0x60000;
+static constexpr unsigned program_size = 0x20000;
 using Iap = void(unsigned[], unsigned[]);                         // IAP entry point function
 static const Iap *iap = (Iap *)0x1FFF1FF1;                        // IAP entry point address
 
-void eeprom_init()
+// Settings log. Instead of erasing and rewriting a sector on each change, a commit appends the changed
+// range of the image to a log as one or more pages. Each log sector starts with a snapshot of the whole
+// image. Once a commit doesn't fit the active sector, the next (oldest) sector is erased and starts with
+// a new snapshot, so sectors are erased in turn. On power-up, the sector with the newest complete
+// snapshot is replayed. A commit is applied only if all of its pages are intact, up to its end page.
+// Power loss at any point therefore recovers either the previous or the new commit, never a mix.
+struct LogPage
+{
+    uint32_t sequence; // Commit sequence number. Erased (0xFFFFFFFF) past the end of the log.
+    uint16_t offset;   // Image offset of data
+    uint8_t length;    // Length of data
+    uint8_t flags;     // log_commit_end, log_snapshot
+    uint32_t checksum; // Checksum of the other fields and data
+    uint8_t data[log_page_data];
+};
+static_assert(sizeof(LogPage) == log_page_size, "Log pages must be exactly one flash page");
+
+static unsigned log_sector = log_sectors;  // Active log sector index. log_sectors if none.
+static unsigned log_page;                  // Next free page in the active sector
+static uint32_t log_sequence;              // Sequence number of the last commit
+static unsigned dirty_begin = flash_size;  // Image range changed since the last commit
+static unsigned dirty_end = 0;
+static bool log_snapshot_due;              // Active sector failed to start. Retried on the next commit.
+
+// Run In-Application Programming (IAP) routines. Flash can't be read while it's being erased or
+// written. The stepper ISR, its vector (see isr_init) and everything it uses are in RAM, so it keeps
+// executing buffered segments meanwhile. All other interrupts are held off until the command is done.
+// USB just NAKs the host in the meantime, so no serial data is lost.
+static bool iap_command(unsigned command[5])
 {
-    memcpy(flash_buffer, flash_memory, flash_size);  // Copy flash memory into local flash buffer
+    unsigned output[5];
+    uint32_t enabled[2] = {NVIC->ISER[0], NVIC->ISER[1]};
+    NVIC->ICER[0] = enabled[0] & ~(1 << TIMER1_IRQn);
+    NVIC->ICER[1] = enabled[1];
+    __DSB();
+    __ISB();
+    iap(command, output);
+    NVIC->ISER[0] = enabled[0];
+    NVIC->ISER[1] = enabled[1];
+    return output[0] == 0; // CMD_SUCCESS
 }
 
-void eeprom_commit()
+static bool flash_erase(unsigned first_sector, unsigned last_sector)
 {
-    if (!memcmp(flash_buffer, flash_memory, flash_size))
-        return; // No changes to commit
     unsigned prepCommand[5] = {
         50,                     // Prepare sector(s) for write operation
-        flash_sector,           // Start sector
-        flash_sector,           // End sector
+        first_sector,           // Start sector
+        last_sector,            // End sector
     };
     unsigned eraseCommand[5] = {
         52,                     // Erase sector(s)
-        flash_sector,           // Start sector
-        flash_sector,           // End sector
+        first_sector,           // Start sector
+        last_sector,            // End sector
         SystemCoreClock / 1000, // CPU clock frequency in kHz
     };
+    return iap_command(prepCommand) && iap_command(eraseCommand);
+}
+
+static bool flash_write(unsigned sector, unsigned addr, char *buffer, unsigned size)
+{
+    unsigned prepCommand[5] = {
+        50,                     // Prepare sector(s) for write operation
+        sector,                 // Start sector
+        sector,                 // End sector
+    };
     unsigned writeCommand[5] = {
         51,                     // Copy RAM to Flash
-        flash_addr,             // Destination flash address (256-byte boundary)
-        (unsigned)flash_buffer, // Source RAM address (word boundary)
-        flash_size,             // Number of bytes to write (must be: 256, 512, 1024, 4096)
+        addr,                   // Destination flash address (256-byte boundary)
+        (unsigned)(uintptr_t)buffer, // Source RAM address (word boundary)
+        size,                   // Number of bytes to write (must be: 256, 512, 1024, 4096)
         SystemCoreClock / 1000, // CPU clock frequency in kHz
     };
-    unsigned output[5];
-    // Run In-Application Programming (IAP) routines
-    iap(prepCommand, output);
-    iap(eraseCommand, output);
-    iap(prepCommand, output);
-    iap(writeCommand, output);
+    return iap_command(prepCommand) && iap_command(writeCommand);
+}
+
+static unsigned log_page_addr(unsigned sector, unsigned page)
+{
+    return log_addr + sector * log_sector_size + page * log_page_size;
+}
+
+static const LogPage *log_get_page(unsigned sector, unsigned page)
+{
+    return (const LogPage *)FLASH_MEMORY(log_page_addr(sector, page));
+}
+
+static uint32_t log_checksum(const LogPage *page)
+{
+    const uint8_t *bytes = (const uint8_t *)page;
+    uint32_t checksum = 0;
+    for (unsigned i = 0; i < log_page_size; ++i)
+        if (i < offsetof(LogPage, checksum) || i >= offsetof(LogPage, data))
+            checksum = ((checksum << 1) | (checksum >> 31)) + bytes[i];
+    return checksum;
+}
+
+static bool log_page_valid(const LogPage *page)
+{
+    return page->sequence != 0xFFFFFFFF && page->length <= log_page_data &&
+           page->offset + page->length <= flash_size && page->checksum == log_checksum(page);
+}
+
+// Returns the number of pages of the complete commit starting at page, or 0 if it's incomplete.
+static unsigned log_commit_pages(unsigned sector, unsigned page)
+{
+    uint32_t sequence = log_get_page(sector, page)->sequence;
+    for (unsigned i = page; i < log_sector_pages; ++i)
+    {
+        auto p = log_get_page(sector, i);
+        if (!log_page_valid(p) || p->sequence != sequence)
+            return 0;
+        if (p->flags & log_commit_end)
+            return i - page + 1;
+    }
+    return 0;
+}
+
+static bool log_page_erased(unsigned sector, unsigned page)
+{
+    auto p = (const uint32_t *)log_get_page(sector, page);
+    for (unsigned i = 0; i < log_page_size / 4; ++i)
+        if (p[i] != 0xFFFFFFFF)
+            return false;
+    return true;
+}
+
+// Replays a log sector into the image. Fails if the sector doesn't start with a complete snapshot.
+static bool log_replay(unsigned sector)
+{
+    if (!(log_get_page(sector, 0)->flags & log_snapshot) || !log_commit_pages(sector, 0))
+        return false;
+    for (unsigned page = 0; page < log_sector_pages;)
+    {
+        unsigned pages = log_commit_pages(sector, page);
+        if (!pages)
+            ++page; // Skip pages of an interrupted commit
+        for (; pages; --pages, ++page)
+        {
+            auto p = log_get_page(sector, page);
+            memcpy(flash_buffer + p->offset, p->data, p->length);
+        }
+    }
+
+    // Append after the last programmed page. Pages of an interrupted commit can't be reused.
+    log_sector = sector;
+    log_page = log_sector_pages;
+    while (log_page > 0 && log_page_erased(sector, log_page - 1))
+        --log_page;
+    return true;
+}
+
+void eeprom_init()
+{
+    // Continue after the newest sequence number found, including those of interrupted commits. A
+    // new commit must never complete the pages of an interrupted one.
+    for (unsigned sector = 0; sector < log_sectors; ++sector)
+        for (unsigned page = 0; page < log_sector_pages; ++page)
+        {
+            auto p = log_get_page(sector, page);
+            if (log_page_valid(p) && p->sequence > log_sequence)
+                log_sequence = p->sequence;
+        }
+
+    // Try sectors from the newest snapshot down. An incomplete new snapshot falls back to its predecessor.
+    bool tried[log_sectors] = {};
+    for (unsigned n = 0; n < log_sectors; ++n)
+    {
+        unsigned newest = log_sectors;
+        for (unsigned sector = 0; sector < log_sectors; ++sector)
+        {
+            auto first = log_get_page(sector, 0);
+            if (!tried[sector] && log_page_valid(first) && (first->flags & log_snapshot) &&
+                (newest == log_sectors || first->sequence > log_get_page(newest, 0)->sequence))
+                newest = sector;
+        }
+        if (newest == log_sectors)
+            break;
+        if (log_replay(newest))
+            return;
+        tried[newest] = true;
+    }
+
+    // No log yet. Import the legacy store. The first commit starts the log with a snapshot.
+    memcpy(flash_buffer, legacy_memory, flash_size);
+}
+
+// Writes image range [begin, end) to the active sector as a single commit.
+static bool log_append(unsigned begin, unsigned end, uint8_t flags)
+{
+    LogPage page;
+    ++log_sequence;
+    while (begin < end)
+    {
+        unsigned length = end - begin < log_page_data ? end - begin : log_page_data;
+        memset(&page, 0xFF, sizeof(page));
+        page.sequence = log_sequence;
+        page.offset = begin;
+        page.length = length;
+        page.flags = flags | (begin + length == end ? log_commit_end : 0);
+        memcpy(page.data, flash_buffer + begin, length);
+        page.checksum = log_checksum(&page);
+        unsigned addr = log_page_addr(log_sector, log_page++); // Skipped on failure. May be partly written.
+        if (!flash_write(log_first_sector + log_sector, addr, (char *)&page, log_page_size))
+            return false;
+        begin += length;
+    }
+    return true;
+}
+
+void eeprom_commit()
+{
+    if (dirty_begin >= dirty_end)
+        return; // No changes to commit
+    unsigned pages = (dirty_end - dirty_begin + log_page_data - 1) / log_page_data;
+    bool written;
+    if (!log_snapshot_due && log_sector < log_sectors && log_page + pages <= log_sector_pages)
+        written = log_append(dirty_begin, dirty_end, 0);
+    else
+    {
+        // Active sector full. Start the next one with a snapshot. Only erases the oldest sector. If
+        // that fails, the same sector is erased again next time, so the older sectors are kept.
+        if (!log_snapshot_due)
+            log_sector = log_sector < log_sectors ? (log_sector + 1) % log_sectors : 0;
+        log_page = 0;
+        written = flash_erase(log_first_sector + log_sector, log_first_sector + log_sector) &&
+                  log_append(0, flash_size, log_snapshot);
+        log_snapshot_due = !written;
+    }
+
+    // Keep the changes until they are written. A failed commit is skipped on replay, and the next
+    // commit writes its range again.
+    if (!written)
+        return;
+    dirty_begin = flash_size;
+    dirty_end = 0;
+}
+
+uint32_t program_flash_size()
+{
+    return program_size;
+}
+
+const char *program_flash_memory()
+{
+    return FLASH_MEMORY(program_addr);
+}
+
+uint8_t program_flash_erase()
+{
+    // Erase one sector at a time. Keeps interrupts from being held off for the whole region.
+    for (unsigned sector = program_first_sector; sector <= program_last_sector; ++sector)
+        if (!flash_erase(sector, sector))
+            return false;
+    return true;
+}
+
+uint8_t program_flash_write(uint32_t offset, char *page)
+{
+    // 32k sectors from 0x10000 up. Pages never cross a sector boundary.
+    unsigned addr = program_addr + offset;
+    return flash_write(16 + (addr - 0x10000) / 0x8000, addr, page, PROGRAM_PAGE_SIZE);
 }
 
 unsigned char eeprom_get_char(unsigned int addr)
@@ -68,9 +312,20 @@ unsigned char eeprom_get_char(unsigned int addr)
     return flash_buffer[addr];
 }
 
+static void eeprom_mark_dirty(unsigned begin, unsigned end)
+{
+    if (begin < dirty_begin)
+        dirty_begin = begin;
+    if (end > dirty_end)
+        dirty_end = end;
+}
+
 void eeprom_put_char(unsigned int addr, unsigned char new_value)
 {
+    if (flash_buffer[addr] == (char)new_value)
+        return;
     flash_buffer[addr] = new_value;
+    eeprom_mark_dirty(addr, addr + 1);
 }
 
 static unsigned char memcpy_with_checksum(char *dest, char *src, unsigned size)
@@ -78,20 +333,37 @@ static unsigned char memcpy_with_checksum(char *dest, char *src, unsigned size)
     unsigned char checksum = 0;
     while (size--)
     {
-        checksum = ((checksum << 1) || (checksum >> 7)) + *src;
+        checksum = ((checksum << 1) | (checksum >> 7)) + *src;
         *dest++ = *src++;
     }
     return checksum;
 }
 
+// Checksum of the records stored by older builds. Their rotation used a logical or, as Grbl did on
+// the AVR, which only adds 1 for any nonzero checksum. Their records are still read, and are written
+// with the rotating checksum the next time they are stored.
+static unsigned char legacy_checksum(const char *src, unsigned size)
+{
+    unsigned char checksum = 0;
+    while (size--)
+        checksum = (checksum != 0) + *src++;
+    return checksum;
+}
+
 void memcpy_to_eeprom_with_checksum(unsigned int destination, char *source, unsigned int size)
 {
+    bool changed = memcmp(flash_buffer + destination, source, size) != 0;
     auto checksum = memcpy_with_checksum(flash_buffer + destination, source, size);
+    changed |= flash_buffer[destination + size] != (char)checksum;
     flash_buffer[destination + size] = checksum;
+    if (changed)
+        eeprom_mark_dirty(destination, destination + size + 1);
 }
 
 int memcpy_from_eeprom_with_checksum(char *destination, unsigned int source, unsigned int size)
 {
     auto checksum = memcpy_with_checksum(destination, flash_buffer + source, size);
-    return checksum == flash_buffer[source + size];
+    if (checksum == flash_buffer[source + size])
+        return true;
+    return legacy_checksum(flash_buffer + source, size) == flash_buffer[source + size];
 }
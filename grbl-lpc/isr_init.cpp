@@ -20,8 +20,21 @@
 
 #include "grbl.h"
 
+extern "C" void (*const g_pfnVectors[])(void);
+
+// Vector table copy in RAM. Flash can't be read while it's erased or written, so interrupts left
+// enabled meanwhile (see iap_command) need both their vector and their handler in RAM.
+static constexpr unsigned vector_count = 16 + PLL1_IRQn + 1;
+static void (*ram_vectors[vector_count])(void) __attribute__((section(".ram_vectors"), aligned(256)));
+
 void isr_init()
 {
+    // Serve interrupts from the RAM vector table
+    for (unsigned i = 0; i < vector_count; ++i)
+        ram_vectors[i] = g_pfnVectors[i];
+    SCB->VTOR = (uint32_t)ram_vectors;
+    __DSB();
+
     // Set all interrupts and system handlers to lowest priority
     for (auto &ip : NVIC->IP)
         ip = 31 << 3;
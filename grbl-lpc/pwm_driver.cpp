@@ -22,6 +22,7 @@
 
 #include "pwm_driver.h"
 #include "LPC17xx.h"
+#include "fastcode.h"
 
 //#include "grbl.h"
 
@@ -42,8 +43,10 @@
     pwm_disable(PWM1_CH1);
 */
 
+// Channel configs are read by pwm_set_width() from the stepper ISR, so they're kept in RAM (.data).
+#define PWM_CHANNEL_DATA __attribute__((section(".data.pwm_channels")))
 
-const PWM_Channel_Config PWM1_CH1 = {
+PWM_CHANNEL_DATA const PWM_Channel_Config PWM1_CH1 = {
     &(LPC_PWM1->MR1),   //Match Register
     (1 << 9),           //PWM Enable
     (1 << 1),           //Latch Enable Register
@@ -51,7 +54,7 @@ const PWM_Channel_Config PWM1_CH1 = {
     (0x1 << 0)          //PINSEL4 - P2.0
 };
 
-const PWM_Channel_Config PWM1_CH2 = {
+PWM_CHANNEL_DATA const PWM_Channel_Config PWM1_CH2 = {
     &(LPC_PWM1->MR2),   //Match Register
     (1 << 10),          //PWM Enable
     (1 << 2),           //Latch Enable Register
@@ -59,7 +62,7 @@ const PWM_Channel_Config PWM1_CH2 = {
     (0x1 << 2)          //PINSEL4 - P2.1
 };
 
-const PWM_Channel_Config PWM1_CH3 = {
+PWM_CHANNEL_DATA const PWM_Channel_Config PWM1_CH3 = {
     &(LPC_PWM1->MR3),   //Match Register
     (1 << 11),          //PWM Enable
     (1 << 3),           //Latch Enable Register
@@ -67,7 +70,7 @@ const PWM_Channel_Config PWM1_CH3 = {
     (0x1 << 4)          //PINSEL4 - P2.2
 };
 
-const PWM_Channel_Config PWM1_CH4 = {
+PWM_CHANNEL_DATA const PWM_Channel_Config PWM1_CH4 = {
     &(LPC_PWM1->MR4),   //Match Register
     (1 << 12),          //PWM Enable
     (1 << 4),           //Latch Enable Register
@@ -75,7 +78,7 @@ const PWM_Channel_Config PWM1_CH4 = {
     (0x1 << 6)          //PINSEL4 - P2.3
 };
 
-const PWM_Channel_Config PWM1_CH5 = {
+PWM_CHANNEL_DATA const PWM_Channel_Config PWM1_CH5 = {
     &(LPC_PWM1->MR5),   //Match Register
     (1 << 13),          //PWM Enable
     (1 << 5),           //Latch Enable Register
@@ -83,7 +86,7 @@ const PWM_Channel_Config PWM1_CH5 = {
     (0x1 << 8)          //PINSEL4 - P2.4
 };
 
-const PWM_Channel_Config PWM1_CH6 = {
+PWM_CHANNEL_DATA const PWM_Channel_Config PWM1_CH6 = {
     &(LPC_PWM1->MR6),   //Match Register
     (1 << 14),          //PWM Enable
     (1 << 6),           //Latch Enable Register
@@ -133,7 +136,7 @@ void pwm_set_period(uint32_t period) {
     LPC_PWM1->LER = 0x00000001;
 }
 
-void pwm_set_width(PWM_Channel_Config* channel, uint32_t width) {
+FASTCODE void pwm_set_width(PWM_Channel_Config* channel, uint32_t width) { // Called by the stepper ISR
     *(channel->MRn) = width;
 
     //If we are running, this will make the MRx register on the next cycle
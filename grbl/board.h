@@ -35,20 +35,53 @@ constexpr static GPIO::Pin leds[] = {
     GPIO::Pin(1, 21, GPIO::Direction::Output)
 };
 
+// Define the motors and the axis each one drives. A motor is driven by the step, direction and enable
+// pins at its index in the step buses below. Ganged axes, like a gantry with a motor on each side, get
+// a motor per driver. Motors of an axis are stepped together through combined pin masks, at no extra
+// cost per step.
+// A motor with a homing switch of its own stops on it during homing, independently of the other motors
+// of its axis. This squares a gantry with a switch on each side. The switch is the index of its pin in
+// the limit bus, or -1 to stop on any switch of the axis.
+// NOTE: The order is crucial, the first N_AXIS motors must be XYZA! Ganged motors follow.
+struct Motor {
+    uint8_t axis;
+    int8_t limit;
+};
+
+constexpr static Motor motors[] = {
+    { 0, -1 }, // X Axis
+    { 1, -1 }, // Y Axis
+    { 2, -1 }, // Z Axis
+    // { 1, 3 }, // Second Y Axis motor on the A driver, squared on the Y max switch. Set Y limit to 2.
+};
+
+constexpr static std::size_t N_MOTORS = sizeof(motors) / sizeof(motors[0]);
+static_assert(N_MOTORS >= N_AXIS, "Each axis needs a motor");
+
+// Returns the combined pin masks of the motors of each axis in a motor bus.
+template<std::size_t N>
+constexpr std::array<uint32_t, N_AXIS> axis_masks(const GPIO::Bus<N>& bus) {
+    std::array<uint32_t, N_AXIS> masks{};
+    for (std::size_t idx = 0; idx < N; idx++) {
+        masks[motors[idx].axis] |= bus.pins[idx].mask;
+    }
+    return masks;
+}
+
 // Define step related pins.
 // NOTE: All pins within a bus must be on the same port.
-// NOTE: The order is crucial, must be XYZA!
+// NOTE: The order is crucial, must follow the motors!
 namespace step {
     // Define step output pins. 
-    constexpr static GPIO::Bus<N_AXIS> step(2, {
+    constexpr static GPIO::Bus<N_MOTORS> step(2, {
         GPIO::Pin(2, 0, GPIO::Direction::Output, GPIO::Pull::None, true, true), // X Axis
         GPIO::Pin(2, 1, GPIO::Direction::Output, GPIO::Pull::None, true, true), // Y Axis
         GPIO::Pin(2, 2, GPIO::Direction::Output, GPIO::Pull::None, true, true), // Z Axis
-        // GPIO::Pin(0, 3, GPIO::Direction::Output, GPIO::Pull::None, true, true)  // A Axis
+        // GPIO::Pin(2, 3, GPIO::Direction::Output, GPIO::Pull::None, true, true)  // A Axis
     });
 
     // Define stepper driver enable/disable output pins.
-    constexpr static GPIO::Bus<N_AXIS> enable(0, {
+    constexpr static GPIO::Bus<N_MOTORS> enable(0, {
         GPIO::Pin(0,  4, GPIO::Direction::Output, GPIO::Pull::None, false, true), // X Axis
         GPIO::Pin(0, 10, GPIO::Direction::Output, GPIO::Pull::None, false, true), // Y Axis
         GPIO::Pin(0, 19, GPIO::Direction::Output, GPIO::Pull::None, false, true), // Z Axis
@@ -56,12 +89,16 @@ namespace step {
     });
 
     // Define step direction output pins.
-    constexpr static GPIO::Bus<N_AXIS> direction(0, {
+    constexpr static GPIO::Bus<N_MOTORS> direction(0, {
         GPIO::Pin(0,  5, GPIO::Direction::Output, GPIO::Pull::None, true, true), // X Axis
         GPIO::Pin(0, 11, GPIO::Direction::Output, GPIO::Pull::None, true, true), // Y Axis
         GPIO::Pin(0, 20, GPIO::Direction::Output, GPIO::Pull::None, true, true), // Z Axis
         // GPIO::Pin(0, 22, GPIO::Direction::Output, GPIO::Pull::None, true, true)  // A Axis
     });
+
+    // Combined step and direction pin masks of each axis.
+    constexpr static std::array<uint32_t, N_AXIS> step_masks = axis_masks(step);
+    constexpr static std::array<uint32_t, N_AXIS> direction_masks = axis_masks(direction);
 }
 
 // Define homing/hard limit switch input pins 
@@ -110,10 +110,6 @@
 // greater.
 #define N_HOMING_LOCATE_CYCLE 1 // Integer (1-128)
 
-// The Z axis generally have a much shorter travel than the XY axes. Running the XY homing on a speed that
-// makes sense for the Z axis on a very large machine takes ages to complete.
-#define Z_HOMING_RATE 250.0
-
 // Enables single axis homing commands. $HX, $HY, and $HZ for X, Y, and Z-axis homing. The full homing 
 // cycle is still invoked by the $H command. This is disabled by default. It's here only to address
 // users that need to switch between a two-axis and three-axis machine. This is actually very rare.
@@ -253,6 +249,17 @@
 #define REPORT_FIELD_OVERRIDES // Default enabled. Comment to disable.
 #define REPORT_FIELD_LINE_NUMBERS // Default enabled. Comment to disable.
 
+// Adds the estimated time of the motion queued in the planner and step segment buffers to the status
+// report, as a 'Qt:' field in milliseconds. Free planner blocks tell little about how long the buffered
+// motion lasts, so a streamer can use it to adapt how far it sends ahead. Reported along with the buffer
+// state field, so the '$10' status report mask turns both on and off.
+#define REPORT_FIELD_QUEUED_TIME // Default enabled. Comment to disable.
+
+// Adds the segment buffer underrun and planner starvation counters of the '$U' command to the status
+// report, as an 'Un:' field. Useful to watch them live while tuning a job or the host link, but not
+// part of the standard report, so it's disabled by default.
+// #define REPORT_FIELD_UNDERRUNS // Default disabled. Uncomment to enable.
+
 // Some status report data isn't necessary for realtime, only intermittently, because the values don't
 // change often. The following macros configures how many times a status report needs to be called before
 // the associated data is refreshed and included in the status report. However, if one of these value
@@ -336,6 +343,19 @@
 //      pwm = scaled value. settings.rpm_min scales to SPINDLE_PWM_MIN_VALUE. settings.rpm_max
 //            scales to SPINDLE_PWM_MAX_VALUE.
 
+// The PWM values are precomputed into a lookup table, which the step segment generator indexes by
+// spindle speed level. The levels divide 0 to settings.rpm_max evenly, so this sets the spindle speed
+// and laser power resolution. The table is rebuilt upon spindle setting and override changes. Each
+// level takes 4 bytes of RAM.
+#define SPINDLE_PWM_LEVELS 512 // Integer (2-65535)
+
+// Calibrates the spindle speed to PWM output mapping for spindles and lasers that don't respond
+// linearly, like VFDs and CO2 laser tubes. Lists the output in percent of the PWM range from
+// SPINDLE_PWM_MIN_VALUE to SPINDLE_PWM_MAX_VALUE, at evenly spaced speeds from settings.rpm_min to
+// settings.rpm_max. Outputs between the listed points are interpolated linearly. When disabled, the
+// scaled value is linear, as above.
+// #define SPINDLE_PWM_CURVE { 0.0, 9.0, 21.0, 36.0, 54.0, 76.0, 100.0 } // Default disabled. Uncomment to enable.
+
 // Used by variable spindle output only. This forces the PWM output to a minimum duty cycle when enabled.
 // The PWM pin will still read 0V when the spindle is disabled. Most users will not need this option, but
 // it may be useful in certain scenarios. This minimum PWM settings coincides with the spindle rpm minimum
@@ -357,6 +377,14 @@
 // to help minimize transmission waiting within the serial write protocol.
 // #define REPORT_ECHO_LINE_RECEIVED // Default disabled. Uncomment to enable.
 
+// Profiles the time critical parts of Grbl with the DWT cycle counter: the stepper and USB ISRs, the
+// segment generator, the planner, the g-code parser, and status reports. Each keeps a count, the
+// min/avg/max execution time and a histogram, printed with the '$T' command and cleared with '$TR'.
+// Each profiled call costs a few dozen cycles. When disabled, the instrumentation is compiled out.
+// NOTE: Times are inclusive. They include time spent in interrupts and, for g-code lines, waiting
+// for room in the planner buffer.
+// #define CPU_PROFILE // Default disabled. Uncomment to enable.
+
 // Minimum planner junction speed. Sets the default minimum junction speed the planner plans to at
 // every buffer block junction, except for starting from rest and end of the buffer, which are always
 // zero. This value controls how fast the machine moves through junctions with no regard for acceleration
@@ -394,6 +422,19 @@
 // time step. Also, keep in mind that the Arduino delay timer is not very accurate for long delays.
 #define DWELL_TIME_STEP 50 // Integer (1-255) (milliseconds)
 
+// Queues spindle, coolant, and dwell commands in the planner buffer, rather than syncing the buffer
+// before executing them. The stepper ISR applies them at their exact place in the path, so look-ahead
+// continues across them. Spindle speed and coolant changes don't stop motion. Spindle start, stop, and
+// direction changes and dwells plan motion to a stop, except spindle changes in laser mode. A zero
+// dwell 'G4 P0' still syncs the buffer, for interfaces that use a dwell to wait for motion to finish.
+#define QUEUE_ACCESSORY_COMMANDS // Default enabled. Comment to disable.
+
+// Canned drilling cycle peck retract distances. After each peck, G83 retracts fully to the R plane to
+// clear chips and then rapids back down to this clearance above the previous peck depth, before feeding
+// the next peck. G73 only backs off by the chip break distance, which is kept short to save time.
+#define CANNED_CYCLE_PECK_CLEARANCE 0.25 // Float (mm)
+#define CANNED_CYCLE_CHIP_BREAK_RETRACT 0.25 // Float (mm)
+
 // Creates a delay between the direction pin setting and corresponding step pulse by creating
 // another interrupt (Timer2 compare) to manage it. The main Grbl interrupt (Timer1 compare)
 // sets the direction pins, and does not immediately set the stepper pins, as it would in
@@ -416,6 +457,16 @@
 // new incoming motions as they are executed.
 #define BLOCK_BUFFER_SIZE 250 // Uncomment to override default in planner.h.
 
+// Grbl starts a cycle from idle as soon as the serial stream pauses with a block in the planner, so the
+// first blocks of a job run with almost no look-ahead and crawl. This gate holds off the automatic cycle
+// start until either the number of blocks or the time of motion below is queued, the serial stream has
+// been idle for the idle time, or a '%' program delimiter line is received. A full planner, a buffer
+// sync, and the cycle start command still start it right away, as does stopping mid-job.
+#define ENABLE_CYCLE_START_GATE // Default enabled. Comment to disable.
+#define CYCLE_START_GATE_BLOCKS 32 // Integer (1-BLOCK_BUFFER_SIZE-1) (blocks)
+#define CYCLE_START_GATE_TIME 500 // Integer (milliseconds of queued motion)
+#define CYCLE_START_GATE_IDLE_TIME 100 // Integer (milliseconds without serial data)
+
 // Governs the size of the intermediary step segment buffer between the step execution algorithm
 // and the planner blocks. Each segment is set of steps executed at a constant velocity over a
 // fixed time defined by ACCELERATION_TICKS_PER_SECOND. They are computed such that the planner
@@ -434,6 +485,17 @@
 // we know how much extra memory space we can re-invest into this.
 // #define LINE_BUFFER_SIZE 80  // Uncomment to override default in protocol.h
 
+// Enables a small cache of parsed g-code lines. Raster and pocketing programs tend to repeat the
+// same short lines many times, like relative moves or spindle and coolant commands. A line found in
+// the cache with the same starting g-code modal state skips word parsing, dispatch, and the STEP 2
+// checks of the g-code parser. Lines are hashed into a direct-mapped table, so the size must be a
+// power of two. Each entry uses around 120 bytes of RAM. Lines longer than the cache line length are
+// never cached. The hit and miss counters are printed with the `$LC` command.
+// NOTE: Error-checking in STEP 3 still runs on every line, since it depends on the machine position
+// and coordinate offsets, which are not part of the cached line.
+#define GC_LINE_CACHE_SIZE 8 // Default enabled. Comment to disable. Must be a power of two.
+#define GC_LINE_CACHE_LINE_LENGTH 32 // Max cached line length, including the terminating null.
+
 // Serial send and receive buffer size. The receive buffer is often used as another streaming
 // buffer to store incoming blocks to be processed by Grbl when its ready. Most streaming
 // interfaces will character count and track each block send to each block response. So,
@@ -507,19 +569,32 @@
 // NOTE: Most EEPROM write commands are implicitly blocked during a job (all '$' commands). However,
 // coordinate set g-code commands (G10,G28/30.1) are not, since they are part of an active streaming
 // job. At this time, this option only forces a planner buffer sync with these g-code commands.
+// NOTE: On the LPC176x, the stepper ISR runs from RAM and keeps stepping while flash is written,
+// and serial data is held off by USB rather than lost. The sync only guards against a segment
+// buffer underrun during a long flash erase.
 #define FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE // Default enabled. Comment to disable.
 
 // LPC176x flash blocks have a rating of 10,000 write cycles. To prevent excess wear, we don't
 // write G10, G28.1, and G30.1. Uncomment to enable these writes.
 #define STORE_COORD_DATA // Default disabled. Uncomment to enable.
 
+// Coordinate data set by g-code commands (G10,G28.1,G30.1) is applied right away, but its flash commit is
+// deferred until Grbl is idle, the program ends (M2,M30), or it's flushed with the '$F' command. Avoids
+// a buffer sync and flash write in the middle of a streaming job, which otherwise stops all motion.
+// NOTE: Deferred data is lost if power is removed before it's committed.
+#define DEFER_COORD_DATA_COMMIT // Default enabled. Comment to disable.
+
 // In Grbl v0.9 and prior, there is an old outstanding bug where the `WPos:` work position reported
 // may not correlate to what is executing, because `WPos:` is based on the g-code parser state, which
 // can be several motions behind. This option forces the planner buffer to empty, sync, and stop
 // motion whenever there is a command that alters the work coordinate offsets `G10,G43.1,G92,G54-59`.
-// This is the simplest way to ensure `WPos:` is always correct. Fortunately, it's exceedingly rare
-// that any of these commands are used need continuous motions through them.
-#define FORCE_BUFFER_SYNC_DURING_WCO_CHANGE // Default enabled. Comment to disable.
+// When disabled, planner blocks are instead tagged with the generation of the work coordinate offset
+// they were planned with, and `WPos:` and `WCO:` are reported with the offset of the executing block.
+// Motion then continues through offset changes, such as switching fixtures between parts. Up to
+// WCO_GENERATIONS offsets can be in the planner buffer, before a change waits for the oldest to finish.
+// It must be a power of two, so the wrapping generation counter maps each generation to its own slot.
+// #define FORCE_BUFFER_SYNC_DURING_WCO_CHANGE // Default disabled. Uncomment to enable.
+#define WCO_GENERATIONS 8 // Integer (2, 4, 8, 16, 32, 64 or 128)
 
 // By default, Grbl disables feed rate overrides for all G38.x probe cycle commands. Although this
 // may be different than some pro-class machine control, it's arguable that it should be this way. 
@@ -528,6 +603,31 @@
 // repeatable. If needed, you can disable this behavior by uncommenting the define below.
 // #define ALLOW_FEED_OVERRIDE_DURING_PROBE_CYCLES // Default disabled. Uncomment to enable.
 
+// Enables height map Z compensation, for surfacing and engraving warped stock like PCBs. The `$ZP`
+// command probes a grid of points and the following motions are offset in Z by the height map,
+// interpolated bilinearly between the grid points. Lines are split into segments of up to
+// HEIGHT_MAP_SEGMENT_LENGTH in the XY plane to follow the map. The map is kept in RAM until cleared
+// with `$ZC` or a power-cycle. HEIGHT_MAP_MAX_POINTS sets the grid size limit per axis.
+#define HEIGHT_MAP // Default enabled. Comment to disable.
+#define HEIGHT_MAP_MAX_POINTS 10 // Integer (2-255)
+#define HEIGHT_MAP_SEGMENT_LENGTH 2.0 // Float (mm)
+
+// Enables raster scanlines for laser engraving images. The pixel powers of a scanline are sent in hex
+// with `$B=` lines and the scanline is run with a single `$BX=` or `$BY=` command, which plans it as
+// one motion. The stepper ISR switches the laser power at the pixel boundaries. Scanlines are queued
+// in RASTER_BUFFER_SIZE buffers of up to RASTER_MAX_PIXELS pixels, which take 1 byte of RAM each.
+// NOTE: Requires VARIABLE_SPINDLE and laser mode.
+#define LASER_RASTER // Default enabled. Comment to disable.
+#define RASTER_BUFFER_SIZE 4 // Integer (2-255)
+#define RASTER_MAX_PIXELS 1024 // Integer (1-65535)
+
+// Overscans raster scanlines, so the pixels are burnt at a constant speed. Each scanline is extended at
+// both ends by laser-off lead-in and lead-out motions, as long as the distance to accelerate to the feed
+// rate, so the accelerations are off the image. The lead-in start is reached by a rapid. The scanline
+// ends at the lead-out end, which becomes the current position.
+// NOTE: Feed overrides above 100% are not reached within the lead-in.
+#define RASTER_OVERSCAN // Default enabled. Comment to disable.
+
 // Enables and configures parking motion methods upon a safety door state. Primarily for OEMs
 // that desire this feature for their integrated machines. At the moment, Grbl assumes that
 // the parking motion only involves one axis, although the parking implementation was written
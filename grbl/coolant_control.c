@@ -23,6 +23,13 @@
 
 using namespace board;
 
+// RAM copies of the coolant pins for coolant_set_outputs(), which the stepper ISR calls. The constexpr
+// originals are in flash, which can't be read while it's written.
+static GPIO::Detail::Bus coolant_flood_port = GPIO::Detail::to_bus(coolant::flood);
+#ifdef ENABLE_M7
+static GPIO::Detail::Bus coolant_mist_port = GPIO::Detail::to_bus(coolant::mist);
+#endif
+
 void coolant_init() {
     coolant::flood.init(); 
 #ifdef ENABLE_M7
@@ -87,6 +94,16 @@ void coolant_set_state(uint8_t mode) {
     sys.report_ovr_counter = 0;  
 }
 
+// Sets the flood and mist coolant pins of the state, turning off those not in it. Called by the
+// stepper ISR for queued coolant commands. Kept in RAM for the stepper ISR.
+FASTCODE void
+coolant_set_outputs(uint8_t mode) {
+    coolant_flood_port.write((mode & COOLANT_FLOOD_ENABLE) ? coolant_flood_port.mask : 0);
+#ifdef ENABLE_M7
+    coolant_mist_port.write((mode & COOLANT_MIST_ENABLE) ? coolant_mist_port.mask : 0);
+#endif
+}
+
 // G-code parser entry-point for setting coolant state. Forces a planner buffer sync and bails
 // if an abort or check-mode is active.
 void
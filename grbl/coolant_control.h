@@ -41,6 +41,9 @@ void coolant_stop();
 // Sets the coolant pins according to state specified.
 void coolant_set_state(uint8_t mode);
 
+// Sets the coolant pins quickly for the stepper ISR, which applies queued coolant commands.
+void coolant_set_outputs(uint8_t mode);
+
 // G-code parser entry-point for setting coolant states. Checks for and executes additional conditions.
 void coolant_sync(uint8_t mode);
 
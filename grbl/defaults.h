@@ -50,6 +50,14 @@
   #define DEFAULT_Y_CURRENT      0.6                // $141 amps (Y stepper current [disabled])
   #define DEFAULT_Z_CURRENT      0.0                // $142 amps (Z stepper current [disabled])
   #define DEFAULT_A_CURRENT      0.0                // $143 amps (A stepper current [disabled])
+  #define DEFAULT_X_HOMING_SEEK_RATE 0.0            // $150 mm/min (X homing search speed; 0 uses $25)
+  #define DEFAULT_Y_HOMING_SEEK_RATE 0.0            // $151 mm/min (Y homing search speed; 0 uses $25)
+  #define DEFAULT_Z_HOMING_SEEK_RATE 250.0          // $152 mm/min (Z homing search speed; 0 uses $25)
+  #define DEFAULT_A_HOMING_SEEK_RATE 0.0            // $153 mm/min (A homing search speed; 0 uses $25)
+  #define DEFAULT_X_HOMING_FEED_RATE 0.0            // $160 mm/min (X homing locate speed; 0 uses $24)
+  #define DEFAULT_Y_HOMING_FEED_RATE 0.0            // $161 mm/min (Y homing locate speed; 0 uses $24)
+  #define DEFAULT_Z_HOMING_FEED_RATE 0.0            // $162 mm/min (Z homing locate speed; 0 uses $24)
+  #define DEFAULT_A_HOMING_FEED_RATE 0.0            // $163 mm/min (A homing locate speed; 0 uses $24)
 
   #define DEFAULT_STEP_PULSE_MICROSECONDS 10        // $0  usec (stepper pulse time)
   #define DEFAULT_STEPPER_IDLE_LOCK_TIME  255       // $1  msec (0-254, 255 keeps steppers enabled)
@@ -72,5 +80,9 @@
   #define DEFAULT_SPINDLE_PWM_OFF_VALUE   1         // $34 % (% of PWM when spindle is off)
   #define DEFAULT_SPINDLE_PWM_MIN_VALUE   1         // $35 % (% of PWM when spindle is at lowest setting)
   #define DEFAULT_SPINDLE_PWM_MAX_VALUE   100       // $36 % (% of PWM when spindle is at highest setting)
+  #define DEFAULT_SLOWDOWN_BUFFER_TIME    0         // $40 msec (queued motion time to start slowing down; 0 disables)
+  #define DEFAULT_SLOWDOWN_MIN_RATE       25        // $41 % (lowest % of nominal speed when slowing down)
+  #define DEFAULT_PROBE_LATCH_RATE        0.0       // $42 mm/min (two-stage probing latch rate; 0 disables)
+  #define DEFAULT_PROBE_RETRACT           2.0       // $43 mm (two-stage probing retract distance)
 
 #endif // end of DEFAULTS_GENERIC
@@ -20,12 +20,14 @@
 */
 
 #include "grbl.h"
+#include <type_traits>
 
 // NOTE: Max line number is defined by the g-code standard to be 99999. It seems to be an
 // arbitrary value, and some GUIs may require more. So we increased it based on a max safe
 // value when converting a float (7.2 digit precision)s to an integer.
 #define MAX_LINE_NUMBER 10000000
 #define MAX_TOOL_NUMBER 255 // Limited by max unsigned 8-bit value
+#define MAX_L_VALUE 255 // Limited by max unsigned 8-bit value
 
 #define AXIS_COMMAND_NONE 0
 #define AXIS_COMMAND_NON_MODAL 1
@@ -38,6 +40,157 @@ parser_block_t gc_block;
 
 #define FAIL(status) return(status);
 
+// Define G and M command dispatch flags. The lower bits hold the axis command type, if any.
+#define GC_CMD_AXIS_MASK     0x03 // AXIS_COMMAND_NON_MODAL, AXIS_COMMAND_MOTION_MODE, or AXIS_COMMAND_TOOL_LENGTH_OFFSET
+#define GC_CMD_NO_STATE      bit(2) // Valid command, but nothing to track. (G40,G61,G91.1,M1)
+#define GC_CMD_HAS_DECIMALS  bit(3) // Command integer value has Gxx.x variants. Others are unsupported, not non-integer.
+
+// G and M command dispatch table. Every supported command word, as its letter, integer value and
+// mantissa, maps to its modal group, dispatch flags, and the value assigned to the block state of
+// that group. Ordered by how often commands typically appear in CAM output, since it is scanned.
+typedef struct {
+  char letter;
+  uint8_t int_value;
+  uint8_t mantissa;
+  uint8_t modal_group;
+  uint8_t flags;
+  uint8_t value;
+} gc_command_t;
+
+static constexpr gc_command_t gc_command_table[] = {
+  { 'G',  1,  0, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_LINEAR },
+  { 'G',  0,  0, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_SEEK },
+  { 'G',  2,  0, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_CW_ARC },
+  { 'G',  3,  0, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_CCW_ARC },
+  { 'M',  3,  0, MODAL_GROUP_M7,  0, SPINDLE_ENABLE_CW },
+  { 'M',  4,  0, MODAL_GROUP_M7,  0, SPINDLE_ENABLE_CCW },
+  { 'M',  5,  0, MODAL_GROUP_M7,  0, SPINDLE_DISABLE },
+  { 'G', 90,  0, MODAL_GROUP_G3,  GC_CMD_HAS_DECIMALS, DISTANCE_MODE_ABSOLUTE }, // G90.1 not supported
+  { 'G', 91,  0, MODAL_GROUP_G3,  GC_CMD_HAS_DECIMALS, DISTANCE_MODE_INCREMENTAL },
+  { 'G', 91, 10, MODAL_GROUP_G4,  GC_CMD_NO_STATE, 0 }, // Arc IJK incremental mode is default. G91.1 does nothing.
+  { 'G', 20,  0, MODAL_GROUP_G6,  0, UNITS_MODE_INCHES },
+  { 'G', 21,  0, MODAL_GROUP_G6,  0, UNITS_MODE_MM },
+  { 'G', 17,  0, MODAL_GROUP_G2,  0, PLANE_SELECT_XY },
+  { 'G', 18,  0, MODAL_GROUP_G2,  0, PLANE_SELECT_ZX },
+  { 'G', 19,  0, MODAL_GROUP_G2,  0, PLANE_SELECT_YZ },
+  { 'G', 93,  0, MODAL_GROUP_G5,  0, FEED_RATE_MODE_INVERSE_TIME },
+  { 'G', 94,  0, MODAL_GROUP_G5,  0, FEED_RATE_MODE_UNITS_PER_MIN },
+  { 'G', 54,  0, MODAL_GROUP_G12, 0, 0 }, // Coordinate systems shifted to array indexing.
+  { 'G', 55,  0, MODAL_GROUP_G12, 0, 1 },
+  { 'G', 56,  0, MODAL_GROUP_G12, 0, 2 },
+  { 'G', 57,  0, MODAL_GROUP_G12, 0, 3 },
+  { 'G', 58,  0, MODAL_GROUP_G12, 0, 4 },
+  { 'G', 59,  0, MODAL_GROUP_G12, 0, 5 }, // NOTE: G59.x are not supported.
+  { 'G', 80,  0, MODAL_GROUP_G1,  0, MOTION_MODE_NONE },
+  { 'G', 81,  0, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_DRILL },
+  { 'G', 82,  0, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_DRILL_DWELL },
+  { 'G', 83,  0, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_DRILL_PECK },
+  { 'G', 73,  0, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_DRILL_CHIP_BREAK },
+  { 'G', 98,  0, MODAL_GROUP_G10, 0, RETRACT_MODE_INITIAL },
+  { 'G', 99,  0, MODAL_GROUP_G10, 0, RETRACT_MODE_R_PLANE },
+  // NOTE: Not required since cutter radius compensation is always disabled. Only here to support
+  // G40 commands that often appear in g-code program headers to setup defaults.
+  { 'G', 40,  0, MODAL_GROUP_G7,  GC_CMD_NO_STATE, CUTTER_COMP_DISABLE },
+  { 'G', 61,  0, MODAL_GROUP_G13, GC_CMD_NO_STATE|GC_CMD_HAS_DECIMALS, CONTROL_MODE_EXACT_PATH }, // G61.1 not supported
+  { 'G',  4,  0, MODAL_GROUP_G0,  0, NON_MODAL_DWELL },
+  { 'G', 10,  0, MODAL_GROUP_G0,  AXIS_COMMAND_NON_MODAL, NON_MODAL_SET_COORDINATE_DATA },
+  { 'G', 28,  0, MODAL_GROUP_G0,  AXIS_COMMAND_NON_MODAL|GC_CMD_HAS_DECIMALS, NON_MODAL_GO_HOME_0 },
+  { 'G', 28, 10, MODAL_GROUP_G0,  0, NON_MODAL_SET_HOME_0 },
+  { 'G', 30,  0, MODAL_GROUP_G0,  AXIS_COMMAND_NON_MODAL|GC_CMD_HAS_DECIMALS, NON_MODAL_GO_HOME_1 },
+  { 'G', 30, 10, MODAL_GROUP_G0,  0, NON_MODAL_SET_HOME_1 },
+  { 'G', 53,  0, MODAL_GROUP_G0,  0, NON_MODAL_ABSOLUTE_OVERRIDE },
+  { 'G', 92,  0, MODAL_GROUP_G0,  AXIS_COMMAND_NON_MODAL|GC_CMD_HAS_DECIMALS, NON_MODAL_SET_COORDINATE_OFFSET },
+  { 'G', 92, 10, MODAL_GROUP_G0,  0, NON_MODAL_RESET_COORDINATE_OFFSET },
+  { 'G', 38, 20, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_PROBE_TOWARD },
+  { 'G', 38, 30, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_PROBE_TOWARD_NO_ERROR },
+  { 'G', 38, 40, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_PROBE_AWAY },
+  { 'G', 38, 50, MODAL_GROUP_G1,  AXIS_COMMAND_MOTION_MODE, MOTION_MODE_PROBE_AWAY_NO_ERROR },
+  { 'G', 43, 10, MODAL_GROUP_G8,  AXIS_COMMAND_TOOL_LENGTH_OFFSET, TOOL_LENGTH_OFFSET_ENABLE_DYNAMIC },
+  { 'G', 49,  0, MODAL_GROUP_G8,  AXIS_COMMAND_TOOL_LENGTH_OFFSET, TOOL_LENGTH_OFFSET_CANCEL },
+  #ifdef ENABLE_M7
+    { 'M',  7,  0, MODAL_GROUP_M8,  0, COOLANT_MIST_ENABLE },
+  #endif
+  { 'M',  8,  0, MODAL_GROUP_M8,  0, COOLANT_FLOOD_ENABLE },
+  { 'M',  9,  0, MODAL_GROUP_M8,  0, COOLANT_DISABLE },
+  { 'M',  0,  0, MODAL_GROUP_M4,  0, PROGRAM_FLOW_PAUSED }, // Program pause
+  { 'M',  1,  0, MODAL_GROUP_M4,  GC_CMD_NO_STATE, PROGRAM_FLOW_OPTIONAL_STOP }, // Optional stop not supported. Ignore.
+  { 'M',  2,  0, MODAL_GROUP_M4,  0, PROGRAM_FLOW_COMPLETED_M2 }, // Program end and reset
+  { 'M', 30,  0, MODAL_GROUP_M4,  0, PROGRAM_FLOW_COMPLETED_M30 },
+  #ifdef ENABLE_PARKING_OVERRIDE_CONTROL
+    { 'M', 56,  0, MODAL_GROUP_M9,  0, OVERRIDE_PARKING_MOTION },
+  #endif
+};
+
+// Byte offset of the block state updated by each modal group, indexed by modal group number.
+// Groups without any tracked state are never written, as all their commands are GC_CMD_NO_STATE.
+static constexpr uint8_t gc_modal_group_field[] = {
+  offsetof(parser_block_t, non_modal_command), // MODAL_GROUP_G0
+  offsetof(parser_block_t, modal.motion),      // MODAL_GROUP_G1
+  offsetof(parser_block_t, modal.plane_select),// MODAL_GROUP_G2
+  offsetof(parser_block_t, modal.distance),    // MODAL_GROUP_G3
+  0,                                           // MODAL_GROUP_G4
+  offsetof(parser_block_t, modal.feed_rate),   // MODAL_GROUP_G5
+  offsetof(parser_block_t, modal.units),       // MODAL_GROUP_G6
+  0,                                           // MODAL_GROUP_G7
+  offsetof(parser_block_t, modal.tool_length), // MODAL_GROUP_G8
+  offsetof(parser_block_t, modal.coord_select),// MODAL_GROUP_G12
+  0,                                           // MODAL_GROUP_G13
+  offsetof(parser_block_t, modal.program_flow),// MODAL_GROUP_M4
+  offsetof(parser_block_t, modal.spindle),     // MODAL_GROUP_M7
+  offsetof(parser_block_t, modal.coolant),     // MODAL_GROUP_M8
+  offsetof(parser_block_t, modal.override),    // MODAL_GROUP_M9
+  offsetof(parser_block_t, modal.retract),     // MODAL_GROUP_G10
+};
+static_assert(sizeof(gc_modal_group_field) == MODAL_GROUP_G10+1, "Modal group field table out of sync");
+
+// The fields are written as single bytes by gc_execute_line(), so each one must be a uint8_t.
+#define GC_FIELD_IS_UINT8(member) std::is_same<decltype(parser_block_t().member), uint8_t>::value
+static_assert(GC_FIELD_IS_UINT8(non_modal_command) && GC_FIELD_IS_UINT8(modal.motion) &&
+              GC_FIELD_IS_UINT8(modal.plane_select) && GC_FIELD_IS_UINT8(modal.distance) &&
+              GC_FIELD_IS_UINT8(modal.feed_rate) && GC_FIELD_IS_UINT8(modal.units) &&
+              GC_FIELD_IS_UINT8(modal.tool_length) && GC_FIELD_IS_UINT8(modal.coord_select) &&
+              GC_FIELD_IS_UINT8(modal.program_flow) && GC_FIELD_IS_UINT8(modal.spindle) &&
+              GC_FIELD_IS_UINT8(modal.coolant) && GC_FIELD_IS_UINT8(modal.override) &&
+              GC_FIELD_IS_UINT8(modal.retract), "Modal group fields must be uint8_t");
+
+
+// Returns the dispatch table entry of a G or M command word, or NULL if not supported.
+static const gc_command_t *gc_lookup_command(char letter, uint32_t int_value, uint16_t mantissa)
+{
+  for (const gc_command_t &command : gc_command_table) {
+    if ((command.int_value == int_value) && (command.mantissa == mantissa) && (command.letter == letter)) {
+      return(&command);
+    }
+  }
+  return(NULL);
+}
+
+
+#ifdef GC_LINE_CACHE_SIZE
+  // Parsed line cache entry. Holds the parser block and word tracking results of STEP 2 for a line,
+  // along with the modal state the line was parsed from, since STEP 2 starts from a copy of it.
+  typedef struct {
+    char line[GC_LINE_CACHE_LINE_LENGTH];
+    gc_modal_t modal;
+    parser_block_t block;
+    uint8_t axis_command;
+    uint8_t axis_words;
+    uint8_t ijk_words;
+    uint16_t command_words;
+    uint16_t value_words;
+  } gc_line_cache_t;
+
+  static gc_line_cache_t gc_line_cache[GC_LINE_CACHE_SIZE];
+  static uint32_t gc_line_cache_hits;
+  static uint32_t gc_line_cache_misses;
+
+  void gc_get_line_cache_counters(uint32_t *hits, uint32_t *misses)
+  {
+    *hits = gc_line_cache_hits;
+    *misses = gc_line_cache_misses;
+  }
+#endif
+
 
 void gc_init()
 {
@@ -47,6 +200,9 @@ void gc_init()
   if (!(settings_read_coord_data(gc_state.modal.coord_select,gc_state.coord_system))) {
     report_status_message(STATUS_SETTING_READ_FAIL);
   }
+  #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+    system_add_wco_generation(); // Record the initial offset for the blocks planned from here on.
+  #endif
 }
 
 
@@ -55,6 +211,10 @@ void gc_init()
 void gc_sync_position()
 {
   system_convert_array_steps_to_mpos(gc_state.position,sys_position);
+  #ifdef HEIGHT_MAP
+    // The parser position excludes the height map offset, which mc_line() adds to each motion.
+    gc_state.position[Z_AXIS] -= heightmap_get_offset(gc_state.position);
+  #endif
 }
 
 
@@ -65,6 +225,7 @@ void gc_sync_position()
 // coordinates, respectively.
 uint8_t gc_execute_line(char *line)
 {
+  PROFILE(PROFILE_GCODE);
   /* -------------------------------------------------------------------------------------
      STEP 1: Initialize parser block struct and copy current g-code state modes. The parser
      updates these modes and commands as the block line is parser and will only be used and
@@ -72,7 +233,15 @@ uint8_t gc_execute_line(char *line)
      values struct, word tracking variables, and a non-modal commands tracker for the new
      block. This struct contains all of the necessary information to execute the block. */
 
-  memset(&gc_block, 0, sizeof(parser_block_t)); // Initialize the parser block struct.
+  // NOTE: The parser block struct is reset lazily. Only the values read by the error-checking and
+  // execution steps, regardless if their word was passed in the block, are given defaults here. All
+  // other values are written by their word before use. IJK are cleared by the first IJK word.
+  gc_block.non_modal_command = NON_MODAL_NO_ACTION;
+  gc_block.values.f = 0.0; // Undefined in G93 mode, unless passed.
+  gc_block.values.l = 0;
+  gc_block.values.n = 0;
+  gc_block.values.p = 0.0;
+  gc_block.values.t = 0;
   memcpy(&gc_block.modal,&gc_state.modal,sizeof(gc_modal_t)); // Copy current modes
 
   uint8_t axis_command = AXIS_COMMAND_NONE;
@@ -94,6 +263,7 @@ uint8_t gc_execute_line(char *line)
     gc_parser_flags |= GC_PARSER_JOG_MOTION;
     gc_block.modal.motion = MOTION_MODE_LINEAR;
     gc_block.modal.feed_rate = FEED_RATE_MODE_UNITS_PER_MIN;
+    clear_vector(gc_block.values.xyza); // Jog target of axes without words. Never initialized otherwise.
     #ifdef USE_LINE_NUMBERS
       gc_block.values.n = JOG_LINE_NUMBER; // Initialize default line number reported during jog.
     #endif
@@ -109,18 +279,48 @@ uint8_t gc_execute_line(char *line)
   uint8_t char_counter;
   char letter;
   float value;
-  uint8_t int_value = 0;
-  uint16_t mantissa = 0;
+  int32_t significand;
+  int8_t exponent;
+  uint32_t int_part;
+  uint16_t mantissa;
+  const gc_command_t *command;
   if (gc_parser_flags & GC_PARSER_JOG_MOTION) { char_counter = 3; } // Start parsing after `$J=`
   else { char_counter = 0; }
 
+  #ifdef GC_LINE_CACHE_SIZE
+    // Look up the line in the parsed line cache. On a hit, restore the parsed block and leave the
+    // counter at the end of the line to skip the word loop. Jog motions are never cached.
+    gc_line_cache_t *cache_entry = NULL;
+    if (!(gc_parser_flags & GC_PARSER_JOG_MOTION)) {
+      uint32_t line_hash = 2166136261; // FNV-1a
+      while (line[char_counter] != 0) { line_hash = (line_hash ^ (uint8_t)line[char_counter++]) * 16777619; }
+      if (char_counter < GC_LINE_CACHE_LINE_LENGTH) {
+        cache_entry = &gc_line_cache[line_hash & (GC_LINE_CACHE_SIZE-1)];
+        if ((strcmp(cache_entry->line,line) == 0) &&
+            (memcmp(&cache_entry->modal,&gc_state.modal,sizeof(gc_modal_t)) == 0)) {
+          memcpy(&gc_block,&cache_entry->block,sizeof(parser_block_t));
+          axis_command = cache_entry->axis_command;
+          axis_words = cache_entry->axis_words;
+          ijk_words = cache_entry->ijk_words;
+          command_words = cache_entry->command_words;
+          value_words = cache_entry->value_words;
+          cache_entry = NULL; // Nothing to store.
+          gc_line_cache_hits++;
+        } else {
+          char_counter = 0;
+          gc_line_cache_misses++;
+        }
+      } else { char_counter = 0; }
+    }
+  #endif
+
   while (line[char_counter] != 0) { // Loop until no more g-code words in line.
 
     // Import the next g-code word, expecting a letter followed by a value. Otherwise, error out.
     letter = line[char_counter];
     if((letter < 'A') || (letter > 'Z')) { FAIL(STATUS_EXPECTED_COMMAND_LETTER); } // [Expected word letter]
     char_counter++;
-    if (!read_float(line, &char_counter, &value)) { FAIL(STATUS_BAD_NUMBER_FORMAT); } // [Expected word value]
+    if (!read_decimal(line, &char_counter, &significand, &exponent)) { FAIL(STATUS_BAD_NUMBER_FORMAT); } // [Expected word value]
 
     // Convert values to smaller uint8 significand and mantissa values for parsing this word.
     // NOTE: Mantissa is multiplied by 100 to catch non-integer command values. This is more
@@ -129,9 +329,9 @@ uint8_t gc_execute_line(char *line)
     // a good enough comprimise and catch most all non-integer errors. To make it compliant,
     // we would simply need to change the mantissa to int16, but this add compiled flash space.
     // Maybe update this later.
-    int_value = trunc(value);
-    mantissa =  round(100*(value - int_value)); // Compute mantissa for Gxx.x commands.
-    // NOTE: Rounding must be used to catch small floating point errors.
+    // NOTE: Split exactly from the parsed decimal digits with integer math. No float rounding
+    // errors to catch, and G/M command words never need a float conversion at all. Only the
+    // words with integer values are split, since it takes an integer division per word.
 
     // Check if the g-code word is supported or errors due to modal group violations or has
     // been repeated in the g-code block. If ok, update the command or record its value.
@@ -140,151 +340,38 @@ uint8_t gc_execute_line(char *line)
       /* 'G' and 'M' Command Words: Parse commands and check for modal group violations.
          NOTE: Modal group numbers are defined in Table 4 of NIST RS274-NGC v3, pg.20 */
 
-      case 'G':
-        // Determine 'G' command and its modal group
-        switch(int_value) {
-          case 10: case 28: case 30: case 92:
-            // Check for G10/28/30/92 being called with G0/1/2/3/38 on same block.
-            // * G43.1 is also an axis command but is not explicitly defined this way.
-            if (mantissa == 0) { // Ignore G28.1, G30.1, and G92.1
-              if (axis_command) { FAIL(STATUS_GCODE_AXIS_COMMAND_CONFLICT); } // [Axis word/command conflict]
-              axis_command = AXIS_COMMAND_NON_MODAL;
-            }
-            // No break. Continues to next line.
-          case 4: case 53:
-            word_bit = MODAL_GROUP_G0;
-            gc_block.non_modal_command = int_value;
-            if ((int_value == 28) || (int_value == 30) || (int_value == 92)) {
-              if (!((mantissa == 0) || (mantissa == 10))) { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); }
-              gc_block.non_modal_command += mantissa;
-              mantissa = 0; // Set to zero to indicate valid non-integer G command.
-            }                
-            break;
-          case 0: case 1: case 2: case 3: case 38:
-            // Check for G0/1/2/3/38 being called with G10/28/30/92 on same block.
-            // * G43.1 is also an axis command but is not explicitly defined this way.
-            if (axis_command) { FAIL(STATUS_GCODE_AXIS_COMMAND_CONFLICT); } // [Axis word/command conflict]
-            axis_command = AXIS_COMMAND_MOTION_MODE;
-            // No break. Continues to next line.
-          case 80:
-            word_bit = MODAL_GROUP_G1;
-            gc_block.modal.motion = int_value;
-            if (int_value == 38){
-              if (!((mantissa == 20) || (mantissa == 30) || (mantissa == 40) || (mantissa == 50))) {
-                FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); // [Unsupported G38.x command]
-              }
-              gc_block.modal.motion += (mantissa/10)+100;
-              mantissa = 0; // Set to zero to indicate valid non-integer G command.
-            }  
-            break;
-          case 17: case 18: case 19:
-            word_bit = MODAL_GROUP_G2;
-            gc_block.modal.plane_select = int_value - 17;
-            break;
-          case 90: case 91:
-            if (mantissa == 0) {
-              word_bit = MODAL_GROUP_G3;
-              gc_block.modal.distance = int_value - 90;
-            } else {
-              word_bit = MODAL_GROUP_G4;
-              if ((mantissa != 10) || (int_value == 90)) { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [G90.1 not supported]
-              mantissa = 0; // Set to zero to indicate valid non-integer G command.
-              // Otherwise, arc IJK incremental mode is default. G91.1 does nothing.
-            }
-            break;
-          case 93: case 94:
-            word_bit = MODAL_GROUP_G5;
-            gc_block.modal.feed_rate = 94 - int_value;
-            break;
-          case 20: case 21:
-            word_bit = MODAL_GROUP_G6;
-            gc_block.modal.units = 21 - int_value;
-            break;
-          case 40:
-            word_bit = MODAL_GROUP_G7;
-            // NOTE: Not required since cutter radius compensation is always disabled. Only here
-            // to support G40 commands that often appear in g-code program headers to setup defaults.
-            // gc_block.modal.cutter_comp = CUTTER_COMP_DISABLE; // G40
-            break;
-          case 43: case 49:
-            word_bit = MODAL_GROUP_G8;
-            // NOTE: The NIST g-code standard vaguely states that when a tool length offset is changed,
-            // there cannot be any axis motion or coordinate offsets updated. Meaning G43, G43.1, and G49
-            // all are explicit axis commands, regardless if they require axis words or not.
-            if (axis_command) { FAIL(STATUS_GCODE_AXIS_COMMAND_CONFLICT); } // [Axis word/command conflict] }
-            axis_command = AXIS_COMMAND_TOOL_LENGTH_OFFSET;
-            if (int_value == 49) { // G49
-              gc_block.modal.tool_length = TOOL_LENGTH_OFFSET_CANCEL;
-            } else if (mantissa == 10) { // G43.1
-              gc_block.modal.tool_length = TOOL_LENGTH_OFFSET_ENABLE_DYNAMIC;
-            } else { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [Unsupported G43.x command]
-            mantissa = 0; // Set to zero to indicate valid non-integer G command.
-            break;
-          case 54: case 55: case 56: case 57: case 58: case 59:
-            // NOTE: G59.x are not supported. (But their int_values would be 60, 61, and 62.)
-            word_bit = MODAL_GROUP_G12;
-            gc_block.modal.coord_select = int_value - 54; // Shift to array indexing.
-            break;
-          case 61:
-            word_bit = MODAL_GROUP_G13;
-            if (mantissa != 0) { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [G61.1 not supported]
-            // gc_block.modal.control = CONTROL_MODE_EXACT_PATH; // G61
-            break;
-          default: FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); // [Unsupported G command]
+      case 'G': case 'M':
+        // Determine the command and its modal group from the dispatch table. The split value is
+        // unsigned, so negative commands are rejected here.
+        if (significand < 0) { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [Negative G or M command]
+        decimal_split(significand, exponent, &int_part, &mantissa);
+        if ((letter == 'M') && (mantissa > 0)) { FAIL(STATUS_GCODE_COMMAND_VALUE_NOT_INTEGER); } // [No Mxx.x commands]
+        command = gc_lookup_command(letter, int_part, mantissa);
+        if (command == NULL) {
+          // Distinguish non-integer values of integer-only commands from unsupported commands.
+          command = gc_lookup_command(letter, int_part, 0);
+          if ((mantissa > 0) && (command != NULL) && !(command->flags & GC_CMD_HAS_DECIMALS)) {
+            FAIL(STATUS_GCODE_COMMAND_VALUE_NOT_INTEGER); // [Unsupported or invalid Gxx.x command]
+          }
+          FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); // [Unsupported G or M command]
+        }
+        word_bit = command->modal_group;
+
+        // Check for G0/1/2/3/38, G10/28/30/92, and G43.1/49 axis commands on the same block.
+        // NOTE: The NIST g-code standard vaguely states that when a tool length offset is changed,
+        // there cannot be any axis motion or coordinate offsets updated. Meaning G43, G43.1, and G49
+        // all are explicit axis commands, regardless if they require axis words or not.
+        if (command->flags & GC_CMD_AXIS_MASK) {
+          if (axis_command) { FAIL(STATUS_GCODE_AXIS_COMMAND_CONFLICT); } // [Axis word/command conflict]
+          axis_command = command->flags & GC_CMD_AXIS_MASK;
         }
-        if (mantissa > 0) { FAIL(STATUS_GCODE_COMMAND_VALUE_NOT_INTEGER); } // [Unsupported or invalid Gxx.x command]
-        // Check for more than one command per modal group violations in the current block
-        // NOTE: Variable 'word_bit' is always assigned, if the command is valid.
-        if ( bit_istrue(command_words,bit(word_bit)) ) { FAIL(STATUS_GCODE_MODAL_GROUP_VIOLATION); }
-        command_words |= bit(word_bit);
-        break;
 
-      case 'M':
-
-        // Determine 'M' command and its modal group
-        if (mantissa > 0) { FAIL(STATUS_GCODE_COMMAND_VALUE_NOT_INTEGER); } // [No Mxx.x commands]
-        switch(int_value) {
-          case 0: case 1: case 2: case 30:
-            word_bit = MODAL_GROUP_M4;
-            switch(int_value) {
-              case 0: gc_block.modal.program_flow = PROGRAM_FLOW_PAUSED; break; // Program pause
-              case 1: break; // Optional stop not supported. Ignore.
-              default: gc_block.modal.program_flow = int_value; // Program end and reset
-            }
-            break;
-          case 3: case 4: case 5:
-            word_bit = MODAL_GROUP_M7;
-            switch(int_value) {
-              case 3: gc_block.modal.spindle = SPINDLE_ENABLE_CW; break;
-              case 4: gc_block.modal.spindle = SPINDLE_ENABLE_CCW; break;
-              case 5: gc_block.modal.spindle = SPINDLE_DISABLE; break;
-            }
-            break;
-          #ifdef ENABLE_M7
-            case 7: case 8: case 9:
-          #else
-            case 8: case 9:
-          #endif
-            word_bit = MODAL_GROUP_M8;
-            switch(int_value) {
-              #ifdef ENABLE_M7
-                case 7: gc_block.modal.coolant = COOLANT_MIST_ENABLE; break;
-              #endif
-              case 8: gc_block.modal.coolant = COOLANT_FLOOD_ENABLE; break;
-              case 9: gc_block.modal.coolant = COOLANT_DISABLE; break;
-            }
-            break;
-          #ifdef ENABLE_PARKING_OVERRIDE_CONTROL
-            case 56:
-              word_bit = MODAL_GROUP_M9;
-              gc_block.modal.override = OVERRIDE_PARKING_MOTION;
-              break;
-          #endif
-          default: FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); // [Unsupported M command]
+        // Update the block modal state or non-modal command of the group.
+        if (!(command->flags & GC_CMD_NO_STATE)) {
+          ((uint8_t *)&gc_block)[gc_modal_group_field[word_bit]] = command->value;
         }
 
         // Check for more than one command per modal group violations in the current block
-        // NOTE: Variable 'word_bit' is always assigned, if the command is valid.
         if ( bit_istrue(command_words,bit(word_bit)) ) { FAIL(STATUS_GCODE_MODAL_GROUP_VIOLATION); }
         command_words |= bit(word_bit);
         break;
@@ -294,7 +381,8 @@ uint8_t gc_execute_line(char *line)
 
         /* Non-Command Words: This initial parsing phase only checks for repeats of the remaining
            legal g-code words and stores their value. Error-checking is performed later since some
-           words (I,J,K,L,P,R) have multiple connotations and/or depend on the issued commands. */
+           words (I,J,K,L,P,Q,R) have multiple connotations and/or depend on the issued commands. */
+        value = decimal_to_float(significand, exponent);
         switch(letter){
           case 'A': word_bit = WORD_A; gc_block.values.xyza[A_AXIS] = value; axis_words |= (1<<A_AXIS); break;
           // case 'B': // Not supported
@@ -302,19 +390,25 @@ uint8_t gc_execute_line(char *line)
           // case 'D': // Not supported
           case 'F': word_bit = WORD_F; gc_block.values.f = value; break;
           // case 'H': // Not supported
-          case 'I': word_bit = WORD_I; gc_block.values.ijk[X_AXIS] = value; ijk_words |= (1<<X_AXIS); break;
-          case 'J': word_bit = WORD_J; gc_block.values.ijk[Y_AXIS] = value; ijk_words |= (1<<Y_AXIS); break;
-          case 'K': word_bit = WORD_K; gc_block.values.ijk[Z_AXIS] = value; ijk_words |= (1<<Z_AXIS); break;
-          case 'L': word_bit = WORD_L; gc_block.values.l = int_value; break;
-          case 'N': word_bit = WORD_N; gc_block.values.n = trunc(value); break;
+          case 'I': word_bit = WORD_I; if (!ijk_words) { clear_vector(gc_block.values.ijk); } gc_block.values.ijk[X_AXIS] = value; ijk_words |= (1<<X_AXIS); break;
+          case 'J': word_bit = WORD_J; if (!ijk_words) { clear_vector(gc_block.values.ijk); } gc_block.values.ijk[Y_AXIS] = value; ijk_words |= (1<<Y_AXIS); break;
+          case 'K': word_bit = WORD_K; if (!ijk_words) { clear_vector(gc_block.values.ijk); } gc_block.values.ijk[Z_AXIS] = value; ijk_words |= (1<<Z_AXIS); break;
+          case 'L': word_bit = WORD_L;
+            if (significand < 0) { FAIL(STATUS_NEGATIVE_VALUE); } // [Negative L value]
+            decimal_split(significand, exponent, &int_part, &mantissa);
+            if (int_part > MAX_L_VALUE) { FAIL(STATUS_GCODE_MAX_VALUE_EXCEEDED); } // [L value too large]
+            gc_block.values.l = int_part;
+            break;
+          case 'N': word_bit = WORD_N; decimal_split(significand, exponent, &int_part, &mantissa); gc_block.values.n = int_part; break;
           case 'P': word_bit = WORD_P; gc_block.values.p = value; break;
           // NOTE: For certain commands, P value must be an integer, but none of these commands are supported.
-          // case 'Q': // Not supported
+          case 'Q': word_bit = WORD_Q; gc_block.values.q = value; break;
           case 'R': word_bit = WORD_R; gc_block.values.r = value; break;
           case 'S': word_bit = WORD_S; gc_block.values.s = value; break;
           case 'T': word_bit = WORD_T; 
-            if (value > MAX_TOOL_NUMBER) { FAIL(STATUS_GCODE_MAX_VALUE_EXCEEDED); }
-            gc_block.values.t = int_value;
+            decimal_split(significand, exponent, &int_part, &mantissa);
+            if (int_part > MAX_TOOL_NUMBER) { FAIL(STATUS_GCODE_MAX_VALUE_EXCEEDED); }
+            gc_block.values.t = int_part;
 			break;
           case 'X': word_bit = WORD_X; gc_block.values.xyza[X_AXIS] = value; axis_words |= (1<<X_AXIS); break;
           case 'Y': word_bit = WORD_Y; gc_block.values.xyza[Y_AXIS] = value; axis_words |= (1<<Y_AXIS); break;
@@ -324,10 +418,10 @@ uint8_t gc_execute_line(char *line)
 
         // NOTE: Variable 'word_bit' is always assigned, if the non-command letter is valid.
         if (bit_istrue(value_words,bit(word_bit))) { FAIL(STATUS_GCODE_WORD_REPEATED); } // [Word repeated]
-        // Check for invalid negative values for words F, N, P, T, and S.
+        // Check for invalid negative values for words F, N, P, Q, T, and S.
         // NOTE: Negative value check is done here simply for code-efficiency.
-        if ( bit(word_bit) & (bit(WORD_F)|bit(WORD_N)|bit(WORD_P)|bit(WORD_T)|bit(WORD_S)) ) {
-          if (value < 0.0) { FAIL(STATUS_NEGATIVE_VALUE); } // [Word value cannot be negative]
+        if ( bit(word_bit) & (bit(WORD_F)|bit(WORD_N)|bit(WORD_P)|bit(WORD_Q)|bit(WORD_T)|bit(WORD_S)) ) {
+          if (significand < 0) { FAIL(STATUS_NEGATIVE_VALUE); } // [Word value cannot be negative]
         }
         value_words |= bit(word_bit); // Flag to indicate parameter assigned.
 
@@ -335,6 +429,20 @@ uint8_t gc_execute_line(char *line)
   }
   // Parsing complete!
 
+  #ifdef GC_LINE_CACHE_SIZE
+    // Store the parsed line before STEP 3 converts the block values in place.
+    if (cache_entry != NULL) {
+      strcpy(cache_entry->line,line);
+      memcpy(&cache_entry->modal,&gc_state.modal,sizeof(gc_modal_t));
+      memcpy(&cache_entry->block,&gc_block,sizeof(parser_block_t));
+      cache_entry->axis_command = axis_command;
+      cache_entry->axis_words = axis_words;
+      cache_entry->ijk_words = ijk_words;
+      cache_entry->command_words = command_words;
+      cache_entry->value_words = value_words;
+    }
+  #endif
+
 
   /* -------------------------------------------------------------------------------------
      STEP 3: Error-check all commands and values passed in this block. This step ensures all of
@@ -512,7 +620,7 @@ uint8_t gc_execute_line(char *line)
 
   // [16. Set path control mode ]: N/A. Only G61. G61.1 and G64 NOT SUPPORTED.
   // [17. Set distance mode ]: N/A. Only G91.1. G90.1 NOT SUPPORTED.
-  // [18. Set retract mode ]: NOT SUPPORTED.
+  // [18. Set retract mode ]: N/A. Only used by canned cycles.
 
   // [19. Remaining non-modal actions ]: Check go to predefined position, set G10, or set axis offsets.
   // NOTE: We need to separate the non-modal commands that are axis word-using (G10/G28/G30/G92), as these
@@ -643,6 +751,8 @@ uint8_t gc_execute_line(char *line)
   }
 
   // [20. Motion modes ]:
+  mc_canned_cycle_t canned_cycle; // Drilling cycle executed by a canned cycle block.
+  float canned_cycle_z = gc_state.cycle_z; // Programmed drilling axis value of a canned cycle block.
   if (gc_block.modal.motion == MOTION_MODE_NONE) {
     // [G80 Errors]: Axis word are programmed while G80 is active.
     // NOTE: Even non-modal commands or TLO that use axis words will throw this strict error.
@@ -806,6 +916,69 @@ uint8_t gc_execute_line(char *line)
             }
           }
           break;
+        case MOTION_MODE_DRILL_CHIP_BREAK: case MOTION_MODE_DRILL:
+        case MOTION_MODE_DRILL_DWELL: case MOTION_MODE_DRILL_PECK:
+          // [G73/81/82/83 Errors]: Feed rate undefined (done). Inverse time mode. No axis words. R word or
+          //   drilling axis word missing, when not retained by an active canned cycle. Q word missing or zero
+          //   for G73/83. L is zero. R plane is below the hole bottom.
+          // NOTE: R, Q, P, and the drilling axis word are retained from the last cycle block, until the motion
+          //   mode changes to a non-canned-cycle mode. R and the drilling axis word observe the distance mode.
+          //   In incremental mode, R is from the drilling axis start position and the hole bottom is from R.
+          if (gc_block.modal.feed_rate == FEED_RATE_MODE_INVERSE_TIME) { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [G93 not supported]
+          if (!axis_words) { FAIL(STATUS_GCODE_NO_AXIS_WORDS); } // [No axis words]
+          canned_cycle.motion = gc_block.modal.motion;
+          canned_cycle.axis_linear = axis_linear;
+          canned_cycle.incremental = gc_block.modal.distance;
+
+          // Load block or retained cycle values. Convert the block values to proper units.
+          if (gc_motion_is_canned_cycle(gc_state.modal.motion)) {
+            if (bit_isfalse(value_words,bit(WORD_R))) { gc_block.values.r = gc_state.cycle_r; }
+            if (bit_isfalse(value_words,bit(WORD_Q))) { gc_block.values.q = gc_state.cycle_q; }
+            if (bit_isfalse(value_words,bit(WORD_P))) { gc_block.values.p = gc_state.cycle_p; }
+          } else {
+            if (bit_isfalse(value_words,bit(WORD_R)) || bit_isfalse(axis_words,bit(axis_linear))) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [R or drilling axis word missing]
+            if (bit_isfalse(value_words,bit(WORD_Q))) { gc_block.values.q = 0.0; }
+            if (bit_isfalse(value_words,bit(WORD_P))) { gc_block.values.p = 0.0; }
+          }
+          if (gc_block.modal.units == UNITS_MODE_INCHES) {
+            if (bit_istrue(value_words,bit(WORD_R))) { gc_block.values.r *= MM_PER_INCH; }
+            if (bit_istrue(value_words,bit(WORD_Q))) { gc_block.values.q *= MM_PER_INCH; }
+          }
+          if (bit_istrue(value_words,bit(WORD_L))) {
+            if (gc_block.values.l == 0) { FAIL(STATUS_GCODE_INVALID_CANNED_CYCLE); } // [L is zero]
+            canned_cycle.repeats = gc_block.values.l;
+          } else { canned_cycle.repeats = 1; }
+          bit_false(value_words,(bit(WORD_R)|bit(WORD_Q)|bit(WORD_P)|bit(WORD_L)));
+
+          if ((gc_block.modal.motion == MOTION_MODE_DRILL_PECK) || (gc_block.modal.motion == MOTION_MODE_DRILL_CHIP_BREAK)) {
+            if (gc_block.values.q == 0.0) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [Q word missing]
+            canned_cycle.peck = gc_block.values.q;
+          } else { canned_cycle.peck = 0.0; }
+          canned_cycle.dwell = gc_block.values.p;
+
+          // Compute the R plane and hole bottom in machine coordinates. The drilling axis value has already
+          // been converted into a target, so the programmed value is recovered to be retained.
+          if (gc_block.modal.distance == DISTANCE_MODE_ABSOLUTE) {
+            float axis_offset = block_coord_system[axis_linear] + gc_state.coord_offset[axis_linear];
+            if (axis_linear == TOOL_LENGTH_OFFSET_AXIS) { axis_offset += gc_state.tool_length_offset; }
+            if (bit_istrue(axis_words,bit(axis_linear))) { canned_cycle_z = gc_block.values.xyza[axis_linear]-axis_offset; }
+            canned_cycle.r_plane = gc_block.values.r + axis_offset;
+            canned_cycle.bottom = canned_cycle_z + axis_offset;
+          } else {
+            if (bit_istrue(axis_words,bit(axis_linear))) { canned_cycle_z = gc_block.values.xyza[axis_linear]-gc_state.position[axis_linear]; }
+            canned_cycle.r_plane = gc_state.position[axis_linear] + gc_block.values.r;
+            canned_cycle.bottom = canned_cycle.r_plane + canned_cycle_z;
+          }
+          if (canned_cycle.r_plane < canned_cycle.bottom) { FAIL(STATUS_GCODE_INVALID_CANNED_CYCLE); } // [R plane below bottom]
+
+          // Retract to the R plane (G99), or to the start position of the drilling axis, but no lower than
+          // the R plane (G98). The parser position is updated with this as the target after execution.
+          canned_cycle.clear_plane = canned_cycle.r_plane;
+          if ((gc_block.modal.retract == RETRACT_MODE_INITIAL) && (gc_state.position[axis_linear] > canned_cycle.r_plane)) {
+            canned_cycle.clear_plane = gc_state.position[axis_linear];
+          }
+          gc_block.values.xyza[axis_linear] = canned_cycle.clear_plane;
+          break;
         case MOTION_MODE_PROBE_TOWARD_NO_ERROR: case MOTION_MODE_PROBE_AWAY_NO_ERROR:
           gc_parser_flags |= GC_PARSER_PROBE_IS_NO_ERROR; // No break intentional.
         case MOTION_MODE_PROBE_TOWARD: case MOTION_MODE_PROBE_AWAY:
@@ -914,9 +1087,18 @@ uint8_t gc_execute_line(char *line)
   pl_data->feed_rate = gc_state.feed_rate; // Record data for planner use.
 
   // [4. Set spindle speed ]:
+  #ifdef QUEUE_ACCESSORY_COMMANDS
+    // Spindle and coolant changes are queued together after [8], as one planner event.
+    uint8_t accessory_event = 0;
+  #endif
   if ((gc_state.spindle_speed != gc_block.values.s) || bit_istrue(gc_parser_flags,GC_PARSER_LASER_FORCE_SYNC)) {
     if (gc_state.modal.spindle != SPINDLE_DISABLE) { 
-      #ifdef VARIABLE_SPINDLE
+      #ifdef QUEUE_ACCESSORY_COMMANDS
+        // NOTE: Speed changes don't stop motion. Without a variable spindle, there's nothing to change.
+        #ifdef VARIABLE_SPINDLE
+          if (bit_isfalse(gc_parser_flags,GC_PARSER_LASER_ISMOTION)) { accessory_event |= PL_EVENT_SPINDLE; }
+        #endif
+      #elif defined(VARIABLE_SPINDLE)
         if (bit_isfalse(gc_parser_flags,GC_PARSER_LASER_ISMOTION)) {
           if (bit_istrue(gc_parser_flags,GC_PARSER_LASER_DISABLE)) {
              spindle_sync(gc_state.modal.spindle, 0.0);
@@ -943,7 +1125,13 @@ uint8_t gc_execute_line(char *line)
     // Update spindle control and apply spindle speed when enabling it in this block.
     // NOTE: All spindle state changes are synced, even in laser mode. Also, pl_data,
     // rather than gc_state, is used to manage laser state for non-laser motions.
-    spindle_sync(gc_block.modal.spindle, pl_data->spindle_speed);
+    #ifdef QUEUE_ACCESSORY_COMMANDS
+      // NOTE: Queued spindle state changes stop motion, except in laser mode.
+      accessory_event |= PL_EVENT_SPINDLE;
+      if (bit_isfalse(settings.flags,BITFLAG_LASER_MODE)) { accessory_event |= PL_EVENT_STOP; }
+    #else
+      spindle_sync(gc_block.modal.spindle, pl_data->spindle_speed);
+    #endif
     gc_state.modal.spindle = gc_block.modal.spindle;
   }
   pl_data->condition |= gc_state.modal.spindle; // Set condition flag for planner use.
@@ -952,11 +1140,18 @@ uint8_t gc_execute_line(char *line)
   if (gc_state.modal.coolant != gc_block.modal.coolant) {
     // NOTE: Coolant M-codes are modal. Only one command per line is allowed. But, multiple states
     // can exist at the same time, while coolant disable clears all states.
-    coolant_sync(gc_block.modal.coolant);
+    #ifdef QUEUE_ACCESSORY_COMMANDS
+      accessory_event |= PL_EVENT_COOLANT;
+    #else
+      coolant_sync(gc_block.modal.coolant);
+    #endif
     if (gc_block.modal.coolant == COOLANT_DISABLE) { gc_state.modal.coolant = COOLANT_DISABLE; }
     else { gc_state.modal.coolant |= gc_block.modal.coolant; }
   }
   pl_data->condition |= gc_state.modal.coolant; // Set condition flag for planner use.
+  #ifdef QUEUE_ACCESSORY_COMMANDS
+    if (accessory_event) { mc_update_accessories(pl_data, accessory_event); }
+  #endif
 
   // [9. Override control ]: NOT SUPPORTED. Always enabled. Except for a Grbl-only parking control.
   #ifdef ENABLE_PARKING_OVERRIDE_CONTROL
@@ -967,7 +1162,7 @@ uint8_t gc_execute_line(char *line)
   #endif
 
   // [10. Dwell ]:
-  if (gc_block.non_modal_command == NON_MODAL_DWELL) { mc_dwell(gc_block.values.p); }
+  if (gc_block.non_modal_command == NON_MODAL_DWELL) { mc_dwell(gc_block.values.p, pl_data); }
 
   // [11. Set active plane ]:
   gc_state.modal.plane_select = gc_block.modal.plane_select;
@@ -1006,7 +1201,8 @@ uint8_t gc_execute_line(char *line)
   // [17. Set distance mode ]:
   gc_state.modal.distance = gc_block.modal.distance;
 
-  // [18. Set retract mode ]: NOT SUPPORTED
+  // [18. Set retract mode ]:
+  gc_state.modal.retract = gc_block.modal.retract;
 
   // [19. Go to predefined position, Set G10, or Set axis offsets ]:
   switch(gc_block.non_modal_command) {
@@ -1058,6 +1254,13 @@ uint8_t gc_execute_line(char *line)
       } else if ((gc_state.modal.motion == MOTION_MODE_CW_ARC) || (gc_state.modal.motion == MOTION_MODE_CCW_ARC)) {
         mc_arc(gc_block.values.xyza, pl_data, gc_state.position, gc_block.values.ijk, gc_block.values.r,
             axis_0, axis_1, axis_linear, bit_istrue(gc_parser_flags,GC_PARSER_ARC_IS_CLOCKWISE));
+      } else if (gc_motion_is_canned_cycle(gc_state.modal.motion)) {
+        // Retain cycle values for the following blocks of the cycle, which may only pass a new hole position.
+        gc_state.cycle_r = gc_block.values.r;
+        gc_state.cycle_z = canned_cycle_z;
+        gc_state.cycle_q = gc_block.values.q;
+        gc_state.cycle_p = gc_block.values.p;
+        mc_canned_cycle(gc_block.values.xyza, pl_data, gc_state.position, &canned_cycle);
       } else {
         // NOTE: gc_block.values.xyza is returned from mc_probe_cycle with the updated position value. So
         // upon a successful probing cycle, the machine position and the returned value should be the same.
@@ -1114,6 +1317,9 @@ uint8_t gc_execute_line(char *line)
         sys.f_override = DEFAULT_FEED_OVERRIDE;
         sys.r_override = DEFAULT_RAPID_OVERRIDE;
         sys.spindle_speed_ovr = DEFAULT_SPINDLE_SPEED_OVERRIDE;
+        #ifdef VARIABLE_SPINDLE
+          spindle_update_pwm_lut();
+        #endif
       #endif
 
       // Execute coordinate change and spindle/coolant stop.
@@ -1122,6 +1328,7 @@ uint8_t gc_execute_line(char *line)
         system_flag_wco_change(); // Set to refresh immediately just in case something altered.
         spindle_set_state(SPINDLE_DISABLE,0.0);
         coolant_set_state(COOLANT_DISABLE);
+        settings_commit_deferred(); // Motion is done. Commit coordinate data set by the program.
       }
       report_feedback_message(MESSAGE_PROGRAM_END);
     }
@@ -1137,7 +1344,7 @@ uint8_t gc_execute_line(char *line)
 /*
   Not supported:
 
-  - Canned cycles
+  - Canned cycles other than G73, G81, G82, and G83
   - Tool radius compensation
   - A,B,C-axes
   - Evaluation of expressions
@@ -1148,13 +1355,12 @@ uint8_t gc_execute_line(char *line)
 
    (*) Indicates optional parameter, enabled through config.h and re-compile
    group 0 = {G92.2, G92.3} (Non modal: Cancel and re-enable G92 offsets)
-   group 1 = {G81 - G89} (Motion modes: Canned cycles)
+   group 1 = {G84 - G89} (Motion modes: Canned cycles)
    group 4 = {M1} (Optional stop, ignored)
    group 6 = {M6} (Tool change)
    group 7 = {G41, G42} cutter radius compensation (G40 is supported)
    group 8 = {G43} tool length offset (G43.1/G49 are supported)
    group 8 = {M7*} enable mist coolant (* Compile-option)
    group 9 = {M48, M49, M56*} enable/disable override switches (* Compile-option)
-   group 10 = {G98, G99} return mode canned cycles
    group 13 = {G61.1, G64} path control mode (G61 is supported)
 */
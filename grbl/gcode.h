@@ -30,7 +30,7 @@
 // and are similar/identical to other g-code interpreters by manufacturers (Haas,Fanuc,Mazak,etc).
 // NOTE: Modal group define values must be sequential and starting from zero.
 #define MODAL_GROUP_G0 0 // [G4,G10,G28,G28.1,G30,G30.1,G53,G92,G92.1] Non-modal
-#define MODAL_GROUP_G1 1 // [G0,G1,G2,G3,G38.2,G38.3,G38.4,G38.5,G80] Motion
+#define MODAL_GROUP_G1 1 // [G0,G1,G2,G3,G38.2,G38.3,G38.4,G38.5,G73,G80,G81,G82,G83] Motion
 #define MODAL_GROUP_G2 2 // [G17,G18,G19] Plane selection
 #define MODAL_GROUP_G3 3 // [G90,G91] Distance mode
 #define MODAL_GROUP_G4 4 // [G91.1] Arc IJK distance mode
@@ -45,6 +45,7 @@
 #define MODAL_GROUP_M7 12 // [M3,M4,M5] Spindle turning
 #define MODAL_GROUP_M8 13 // [M7,M8,M9] Coolant control
 #define MODAL_GROUP_M9 14 // [M56] Override control
+#define MODAL_GROUP_G10 15 // [G98,G99] Canned cycle return mode
 
 // Define command actions for within execution-type modal groups (motion, stopping, non-modal). Used
 // internally by the parser to know which command to execute.
@@ -75,6 +76,10 @@
 #define MOTION_MODE_PROBE_AWAY 142 // G38.4 (Do not alter value)
 #define MOTION_MODE_PROBE_AWAY_NO_ERROR 143 // G38.5 (Do not alter value)
 #define MOTION_MODE_NONE 80 // G80 (Do not alter value)
+#define MOTION_MODE_DRILL_CHIP_BREAK 73 // G73 (Do not alter value)
+#define MOTION_MODE_DRILL 81 // G81 (Do not alter value)
+#define MOTION_MODE_DRILL_DWELL 82 // G82 (Do not alter value)
+#define MOTION_MODE_DRILL_PECK 83 // G83 (Do not alter value)
 
 // Modal Group G2: Plane select
 #define PLANE_SELECT_XY 0 // G17 (Default: Must be zero)
@@ -106,6 +111,10 @@
 // Modal Group G7: Cutter radius compensation mode
 #define CUTTER_COMP_DISABLE 0 // G40 (Default: Must be zero)
 
+// Modal Group G10: Canned cycle return mode
+#define RETRACT_MODE_INITIAL 0 // G98 (Default: Must be zero)
+#define RETRACT_MODE_R_PLANE 1 // G99 (Do not alter value)
+
 // Modal Group G13: Control mode
 #define CONTROL_MODE_EXACT_PATH 0 // G61 (Default: Must be zero)
 
@@ -150,6 +159,7 @@
 #define WORD_Y  11
 #define WORD_Z  12
 #define WORD_A  13
+#define WORD_Q  14
 
 // Define g-code parser position updating flags
 #define GC_UPDATE_POS_TARGET   0 // Must be zero
@@ -181,7 +191,7 @@
 
 // NOTE: When this struct is zeroed, the above defines set the defaults for the system.
 typedef struct {
-  uint8_t motion;          // {G0,G1,G2,G3,G38.2,G80}
+  uint8_t motion;          // {G0,G1,G2,G3,G38.2,G73,G80,G81,G82,G83}
   uint8_t feed_rate;       // {G93,G94}
   uint8_t units;           // {G20,G21}
   uint8_t distance;        // {G90,G91}
@@ -195,6 +205,7 @@ typedef struct {
   uint8_t coolant;         // {M7,M8,M9}
   uint8_t spindle;         // {M3,M4,M5}
   uint8_t override;        // {M56}
+  uint8_t retract;         // {G98,G99}
 } gc_modal_t;
 
 typedef struct {
@@ -203,7 +214,7 @@ typedef struct {
   uint8_t l;       // G10 or canned cycles parameters
   int32_t n;       // Line number
   float p;         // G10 or dwell parameters
-  // float q;      // G82 peck drilling
+  float q;         // G73 or G83 peck depth
   float r;         // Arc radius
   float s;         // Spindle speed
   uint8_t t;       // Tool selection
@@ -226,6 +237,11 @@ typedef struct {
   float coord_offset[N_AXIS];    // Retains the G92 coordinate offset (work coordinates) relative to
                                  // machine zero in mm. Non-persistent. Cleared upon reset and boot.
   float tool_length_offset;      // Tracks tool length offset value when enabled.
+
+  float cycle_r;                 // Canned cycle R, drilling axis, Q, and P values of the last cycle block in mm
+  float cycle_z;                 // and seconds. Retained while a canned cycle motion mode is active. R and the
+  float cycle_q;                 // drilling axis value are as programmed in the distance mode of that block.
+  float cycle_p;
 } parser_state_t;
 extern parser_state_t gc_state;
 
@@ -237,6 +253,10 @@ typedef struct {
 } parser_block_t;
 
 
+// Returns true, if the motion mode is a canned drilling cycle.
+#define gc_motion_is_canned_cycle(motion) (((motion) == MOTION_MODE_DRILL_CHIP_BREAK) || \
+  (((motion) >= MOTION_MODE_DRILL) && ((motion) <= MOTION_MODE_DRILL_PECK)))
+
 // Initialize the parser
 void gc_init();
 
@@ -246,4 +266,9 @@ uint8_t gc_execute_line(char *line);
 // Set g-code parser position. Input in steps.
 void gc_sync_position();
 
+#ifdef GC_LINE_CACHE_SIZE
+  // Get the parsed line cache hit and miss counters.
+  void gc_get_line_cache_counters(uint32_t *hits, uint32_t *misses);
+#endif
+
 #endif
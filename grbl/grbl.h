@@ -37,11 +37,13 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // Define the Grbl system include files. NOTE: Do not alter organization.
 #include "debug.h"
 #include "config.h"
 #include "delay.h"
+#include "fastcode.h"
 #include "nuts_bolts.h"
 #include "settings.h"
 #include "system.h"
@@ -51,12 +53,16 @@
 #include "coolant_control.h"
 #include "eeprom.h"
 #include "gcode.h"
+#include "heightmap.h"
 #include "limits.h"
 #include "motion_control.h"
 #include "planner.h"
 #include "print.h"
 #include "probe.h"
+#include "program.h"
+#include "profile.h"
 #include "protocol.h"
+#include "raster.h"
 #include "report.h"
 #include "serial.h"
 #include "spindle_control.h"
@@ -91,6 +97,10 @@
 #endif
 */
 
+#if defined(LASER_RASTER) && !defined(VARIABLE_SPINDLE)
+  #error "LASER_RASTER requires VARIABLE_SPINDLE."
+#endif
+
 #if (REPORT_WCO_REFRESH_BUSY_COUNT < REPORT_WCO_REFRESH_IDLE_COUNT)
   #error "WCO busy refresh is less than idle refresh."
 #endif
@@ -0,0 +1,158 @@
+/*
+  heightmap.c - height map probing and Z compensation
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+#ifdef HEIGHT_MAP
+
+static heightmap_t hmap;
+
+// Bilinear coefficients of each grid cell, indexed [y][x]. The offset in a cell is
+// c[0] + c[1]*u + c[2]*v + c[3]*u*v, where u and v are the X and Y distances from its first grid
+// point. Computed once the map is probed, so compensating a line segment takes a few multiplies.
+static float hmap_cell[HEIGHT_MAP_MAX_POINTS-1][HEIGHT_MAP_MAX_POINTS-1][4];
+static float hmap_inv_spacing[2];
+
+
+static void heightmap_compute_cells()
+{
+  uint8_t x, y;
+  for (y=0; y<hmap.n_points[Y_AXIS]-1; y++) {
+    for (x=0; x<hmap.n_points[X_AXIS]-1; x++) {
+      float h00 = hmap.height[y][x];
+      float h10 = hmap.height[y][x+1];
+      float h01 = hmap.height[y+1][x];
+      float h11 = hmap.height[y+1][x+1];
+      float *c = hmap_cell[y][x];
+      c[0] = h00;
+      c[1] = (h10-h00)*hmap_inv_spacing[X_AXIS];
+      c[2] = (h01-h00)*hmap_inv_spacing[Y_AXIS];
+      c[3] = (h11-h10-h01+h00)*hmap_inv_spacing[X_AXIS]*hmap_inv_spacing[Y_AXIS];
+    }
+  }
+}
+
+
+// Rapids to a machine position and waits until the machine is there. Returns false upon an abort.
+static uint8_t heightmap_move(float *target)
+{
+  plan_line_data_t pl_data;
+  memset(&pl_data,0,sizeof(plan_line_data_t));
+  pl_data.condition = PL_COND_FLAG_RAPID_MOTION;
+  mc_line(target, &pl_data);
+  protocol_buffer_synchronize();
+  return(!sys.abort);
+}
+
+
+uint8_t heightmap_probe(uint8_t x_points, uint8_t y_points, float x_spacing, float y_spacing,
+  float depth, float feed_rate)
+{
+  if ((x_points < 2) || (y_points < 2)) { return(STATUS_INVALID_STATEMENT); }
+  if ((x_points > HEIGHT_MAP_MAX_POINTS) || (y_points > HEIGHT_MAP_MAX_POINTS)) { return(STATUS_INVALID_STATEMENT); }
+  if ((x_spacing <= 0.0) || (y_spacing <= 0.0) || (depth <= 0.0) || (feed_rate <= 0.0)) { return(STATUS_NEGATIVE_VALUE); }
+
+  // The old map must not compensate the probing motions.
+  heightmap_clear();
+  gc_sync_position();
+
+  float start[N_AXIS], target[N_AXIS], probe_position[N_AXIS];
+  system_convert_array_steps_to_mpos(start, sys_position);
+  memcpy(target, start, sizeof(start));
+  plan_line_data_t pl_data;
+  uint8_t x, y, idx;
+  for (y=0; y<y_points; y++) {
+    for (idx=0; idx<x_points; idx++) {
+      x = (y & 1) ? (x_points-1-idx) : idx; // Serpentine order, so each move is to a neighbouring point.
+      target[X_AXIS] = start[X_AXIS]+x*x_spacing;
+      target[Y_AXIS] = start[Y_AXIS]+y*y_spacing;
+      if (!heightmap_move(target)) { return(STATUS_HEIGHT_MAP_PROBE_FAIL); } // At the start Z.
+
+      target[Z_AXIS] = start[Z_AXIS]-depth;
+      memset(&pl_data,0,sizeof(plan_line_data_t));
+      pl_data.feed_rate = feed_rate;
+      #ifndef ALLOW_FEED_OVERRIDE_DURING_PROBE_CYCLES
+        pl_data.condition = PL_COND_FLAG_NO_FEED_OVERRIDE;
+      #endif
+      if (mc_probe_cycle(target, &pl_data, 0) != GC_PROBE_FOUND) {
+        gc_sync_position(); // The probe cycle raised an alarm or was aborted. No map is loaded.
+        return(STATUS_HEIGHT_MAP_PROBE_FAIL);
+      }
+      probe_get_position(probe_position);
+      hmap.height[y][x] = probe_position[Z_AXIS];
+
+      // Lift straight up off the surface, before moving on to the next point in XY.
+      target[Z_AXIS] = start[Z_AXIS];
+      if (!heightmap_move(target)) { return(STATUS_HEIGHT_MAP_PROBE_FAIL); }
+    }
+  }
+
+  // Heights are taken relative to the first point.
+  for (y=0; y<y_points; y++) {
+    for (x=0; x<x_points; x++) {
+      if (x || y) { hmap.height[y][x] -= hmap.height[0][0]; }
+    }
+  }
+  hmap.height[0][0] = 0.0;
+  hmap.n_points[X_AXIS] = x_points;
+  hmap.n_points[Y_AXIS] = y_points;
+  hmap.origin[X_AXIS] = start[X_AXIS];
+  hmap.origin[Y_AXIS] = start[Y_AXIS];
+  hmap.spacing[X_AXIS] = x_spacing;
+  hmap.spacing[Y_AXIS] = y_spacing;
+  hmap_inv_spacing[X_AXIS] = 1.0/x_spacing;
+  hmap_inv_spacing[Y_AXIS] = 1.0/y_spacing;
+  heightmap_compute_cells();
+  hmap.valid = true;
+
+  gc_sync_position(); // Sync to the compensated position, now that the map is loaded.
+  return(STATUS_OK);
+}
+
+
+void heightmap_clear()
+{
+  hmap.valid = false;
+}
+
+
+uint8_t heightmap_is_valid() { return(hmap.valid); }
+
+
+const heightmap_t *heightmap_get() { return(&hmap); }
+
+
+float heightmap_get_offset(float *position)
+{
+  if (!hmap.valid) { return(0.0); }
+  uint8_t cell[2];
+  float distance[2];
+  uint8_t idx;
+  for (idx=X_AXIS; idx<=Y_AXIS; idx++) {
+    float last_cell = hmap.n_points[idx]-2;
+    distance[idx] = (position[idx]-hmap.origin[idx])*hmap_inv_spacing[idx]; // In grid cells
+    if (distance[idx] < 0.0) { distance[idx] = 0.0; }
+    else if (distance[idx] > (last_cell+1.0)) { distance[idx] = last_cell+1.0; }
+    cell[idx] = std::min(floorf(distance[idx]), last_cell);
+    distance[idx] = (distance[idx]-cell[idx])*hmap.spacing[idx];
+  }
+  const float *c = hmap_cell[cell[Y_AXIS]][cell[X_AXIS]];
+  return(c[0] + c[1]*distance[X_AXIS] + (c[2] + c[3]*distance[X_AXIS])*distance[Y_AXIS]);
+}
+
+#endif
@@ -0,0 +1,53 @@
+/*
+  heightmap.h - height map probing and Z compensation
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef heightmap_h
+#define heightmap_h
+
+#ifdef HEIGHT_MAP
+  // Height map grid. Points are spaced in machine coordinates from the origin, which is the first
+  // probed point. Heights are relative to the origin height, so compensation is zero there.
+  typedef struct {
+    uint8_t valid;
+    uint8_t n_points[2];  // Grid points along X and Y.
+    float origin[2];      // Machine position of the first grid point. (mm)
+    float spacing[2];     // Distance between grid points. (mm)
+    float height[HEIGHT_MAP_MAX_POINTS][HEIGHT_MAP_MAX_POINTS]; // Indexed [y][x]. (mm)
+  } heightmap_t;
+
+  // Probes a grid of x_points by y_points from the current position, spaced by x_spacing and y_spacing
+  // in positive X and Y. Each point is probed by up to depth below the current Z at the feed rate, and
+  // the tool rapids back to the current Z between points. ($ZP)
+  uint8_t heightmap_probe(uint8_t x_points, uint8_t y_points, float x_spacing, float y_spacing,
+    float depth, float feed_rate);
+
+  // Clears the height map, which disables compensation. ($ZC)
+  void heightmap_clear();
+
+  // Returns true, if a height map is loaded and motions are compensated.
+  uint8_t heightmap_is_valid();
+
+  // Returns the height map, for reporting.
+  const heightmap_t *heightmap_get();
+
+  // Returns the Z offset of the height map at the XY of a machine position. Positions outside the
+  // grid take the height of the nearest grid edge. Zero, if no height map is loaded.
+  float heightmap_get_offset(float *position);
+#endif
+
+#endif
@@ -49,10 +49,7 @@ void limits_disable() {
 // Returns limit state as a bit-wise uint8 variable. Each bit indicates an axis limit, where
 // triggered is 1 and not triggered is 0. Invert mask is applied. Axes are defined by their
 // number in bit position, i.e. Z_AXIS is (1<<2) or bit 2, and Y_AXIS is (1<<1) or bit 1.
-uint8_t limits_get_state() {
-    // Get the logical state of all limits pins atomically
-    uint32_t bus_state = limit.read();
-
+static uint8_t limits_get_axis_state(uint32_t bus_state) {
     // Set axis limit state in case min or max is triggered
     uint8_t state = 0;
     for (uint8_t axis = 0; axis < N_AXIS; axis++) {
@@ -65,6 +62,29 @@ uint8_t limits_get_state() {
     return state;
 }
 
+uint8_t limits_get_state() {
+    // Get the logical state of all limits pins atomically
+    return limits_get_axis_state(limit.read());
+}
+
+#ifndef COREXY
+// Returns the step pins of the motors, which reached their homing switch. Motors with a switch of
+// their own stop on it, which squares a ganged axis. Others stop on any switch of their axis.
+static uint32_t limits_get_homed_motors() {
+    uint32_t bus_state = limit.read();
+    uint8_t axis_state = limits_get_axis_state(bus_state);
+    uint32_t homed = 0;
+    for (uint8_t motor = 0; motor < N_MOTORS; motor++) {
+        int8_t limit_idx = motors[motor].limit;
+        if ((limit_idx < 0) ? (axis_state & bit(motors[motor].axis))
+                            : (bus_state & limit.pins[limit_idx].mask)) {
+            homed |= step::step.pins[motor].mask;
+        }
+    }
+    return homed;
+}
+#endif
+
 // This is the Limit Pin Change Interrupt, which handles the hard limit feature. A bouncing
 // limit switch can cause a lot of problems, like false readings and multiple interrupt calls.
 // If a switch is triggered at all, something bad has happened and treat it as such, regardless
@@ -100,6 +120,21 @@ ISR(_todo_isr_vector)
 #endif
 }
 
+// Returns the homing rate of an axis, at the seek or the locate feed rate. The per-axis homing rate
+// settings override the common ones, unless zero.
+static float limits_get_homing_rate(uint8_t axis, bool seek) {
+    if (seek) {
+        if (settings.axis_homing_seek_rate[axis] > 0.0) {
+            return settings.axis_homing_seek_rate[axis];
+        }
+        return settings.homing_seek_rate;
+    }
+    if (settings.axis_homing_feed_rate[axis] > 0.0) {
+        return settings.axis_homing_feed_rate[axis];
+    }
+    return settings.homing_feed_rate;
+}
+
 // Homes the specified cycle axes, sets the machine position, and performs a pull-off motion after
 // completing. Homing is a special motion case, which involves rapid uncontrolled stops to locate
 // the trigger point of the limit switches. The rapid stops are handled by a system level axis lock
@@ -124,154 +159,200 @@ void limits_go_home(uint8_t cycle_mask) {
     uint8_t n_cycle = (N_HOMING_LOCATE_CYCLE + 1);
     uint32_t step_mask[N_AXIS];  // Tracks which pins correspond to which axes
     float target[N_AXIS];
-    float max_travel = 0.0;  // Maximum travel distance to move searching for limits
+    float travel[N_AXIS];  // Travel distance of each axis, searching for limits or pulling off
     uint8_t axis;
     for (axis = 0; axis < N_AXIS; axis++) {
         // Initialize pin masks
 #ifdef COREXY
         if ((axis == A_MOTOR) || (axis == B_MOTOR)) {
-            step_mask[axis] = step::step.pins[X_AXIS].mask;
-            step_mask[axis] = step::step.pins[Y_AXIS].mask;
+            step_mask[axis] = step::step_masks[X_AXIS];
+            step_mask[axis] = step::step_masks[Y_AXIS];
         }
 #else
-        step_mask[axis] = step::step.pins[axis].mask;
+        step_mask[axis] = step::step_masks[axis];  // Includes any ganged motors of the axis.
 #endif
 
-        if (bit_istrue(cycle_mask, bit(axis))) {
-            // Set target based on max_travel setting. Ensure homing switches engaged with search
-            // scalar. NOTE: settings.max_travel[] is stored as a negative value.
-            max_travel =
-                std::max(max_travel, (-HOMING_AXIS_SEARCH_SCALAR) * settings.max_travel[axis]);
-        }
+        // Set search travel based on max_travel setting. Ensure homing switches engaged with search
+        // scalar. NOTE: settings.max_travel[] is stored as a negative value.
+        travel[axis] = (-HOMING_AXIS_SEARCH_SCALAR) * settings.max_travel[axis];
     }
 
     // Set search mode with approach at seek rate to quickly engage the specified cycle_mask limit
     // switches.
     bool approach = true;
-    float homing_rate = settings.homing_seek_rate;
+    bool seek = true;
 
-    uint32_t limit_state, axislock, n_active_axis;
+    uint32_t axislock;
     do {
-        // convert current sys_position (steps) to target (mm) so unused axes remain in place
-        system_convert_array_steps_to_mpos(target, sys_position);
-
-        // Initialize and declare variables needed for homing routine.
+        // Each axis moves at its own homing rate and stops on its own switch. A homing motion lasts
+        // until the first of its axes has covered its travel, so no axis moves past its own search or
+        // pull-off distance. The motion is repeated with the remaining axes and travel, until each
+        // axis has found its switch or covered its travel. Acceleration is limited per axis by the
+        // planner.
+        float rate[N_AXIS];
+        float remaining[N_AXIS];  // Travel left to each axis in this pass
+        uint8_t pass_mask = 0;    // Axes still moving in this pass
         axislock = 0;  // Track which pins still need to find limits. Lock these axes by clearing
                        // these bits.
-        n_active_axis = 0;  // Track number of axes being homed
         for (axis = 0; axis < N_AXIS; axis++) {
-            // Set target location for active axes and setup computation for homing rate.
             if (bit_istrue(cycle_mask, bit(axis))) {
-                n_active_axis++;
-#ifdef COREXY
-                if (axis == X_AXIS) {
-                    int32_t axis_position = system_convert_corexy_to_y_axis_steps(sys_position);
-                    sys_position[A_MOTOR] = axis_position;
-                    sys_position[B_MOTOR] = -axis_position;
-                } else if (axis == Y_AXIS) {
-                    int32_t axis_position = system_convert_corexy_to_x_axis_steps(sys_position);
-                    sys_position[A_MOTOR] = sys_position[B_MOTOR] = axis_position;
-                } else {
-                    sys_position[Z_AXIS] = 0;
-                }
-#else
-                sys_position[axis] = 0;
-#endif
-                // Set target direction based on cycle mask and homing cycle approach state.
-                // NOTE: This happens to compile smaller than any other implementation tried.
-                if (bit_istrue(settings.homing_dir_mask, bit(axis))) {
-                    if (approach) {
-                        target[axis] = -max_travel;
-                    } else {
-                        target[axis] = max_travel;
-                    }
-                } else {
-                    if (approach) {
-                        target[axis] = max_travel;
-                    } else {
-                        target[axis] = -max_travel;
-                    }
+                rate[axis] = limits_get_homing_rate(axis, seek);
+                remaining[axis] = travel[axis];
+                if (remaining[axis] > 0.0) {
+                    pass_mask |= bit(axis);
                 }
                 // Apply axislock to the step port pins active in this cycle, allowing motion
                 axislock |= step_mask[axis];
             }
         }
-        homing_rate *= sqrt(
-            n_active_axis);  // [sqrt(N_AXIS)] Adjust so individual axes all move at homing rate.
-        sys.homing_axis_lock = axislock;
-
-        // Perform homing cycle. Planner buffer should be empty, as required to initiate the homing
-        // cycle.
-        if (axis == Z_AXIS) {
-            pl_data->feed_rate = Z_HOMING_RATE;
-        } else {
-            pl_data->feed_rate = homing_rate;   // Set current homing rate.
-        }
-        plan_buffer_line(target, pl_data);  // Bypass mc_line(). Directly plan homing motion.
 
-        sys.step_control = STEP_CONTROL_EXECUTE_SYS_MOTION;  // Set to execute homing motion and
-                                                             // clear existing flags.
-        st_prep_buffer();  // Prep and fill segment buffer from newly planned block.
-        st_wake_up();      // Initiate motion
-        do {
-            if (approach) {
-                // Check limit state. Lock out cycle axes when they change.
-                limit_state = limits_get_state();
-                for (axis = 0; axis < N_AXIS; axis++) {
-                    if (axislock & step_mask[axis]) {
-                        if (limit_state & (1 << axis)) {
-// Clear the axislock bits to prevent axis from moving after limit is hit
+        while (pass_mask) {
+            // convert current sys_position (steps) to target (mm) so unused axes remain in place
+            system_convert_array_steps_to_mpos(target, sys_position);
+
+            float cycle_time = SOME_LARGE_VALUE;
+            float feed_rate_sqr = 0.0;
+            for (axis = 0; axis < N_AXIS; axis++) {
+                if (bit_istrue(pass_mask, bit(axis))) {
+                    cycle_time = std::min(cycle_time, remaining[axis] / rate[axis]);
+                    feed_rate_sqr += rate[axis] * rate[axis];
+                }
+            }
+
+            for (axis = 0; axis < N_AXIS; axis++) {
+                // Set target location for active axes.
+                if (bit_istrue(pass_mask, bit(axis))) {
+                    float axis_travel = rate[axis] * cycle_time;
 #ifdef COREXY
-                            if (axis == Z_AXIS) {
-                                axislock &= ~(step_mask[Z_AXIS]);
-                            } else {
-                                axislock &= ~(step_mask[A_MOTOR] | step_mask[B_MOTOR]);
-                            }
+                    if (axis == X_AXIS) {
+                        int32_t axis_position = system_convert_corexy_to_y_axis_steps(sys_position);
+                        sys_position[A_MOTOR] = axis_position;
+                        sys_position[B_MOTOR] = -axis_position;
+                    } else if (axis == Y_AXIS) {
+                        int32_t axis_position = system_convert_corexy_to_x_axis_steps(sys_position);
+                        sys_position[A_MOTOR] = sys_position[B_MOTOR] = axis_position;
+                    } else {
+                        sys_position[Z_AXIS] = 0;
+                    }
 #else
-                            axislock &= ~(step_mask[axis]);
+                    sys_position[axis] = 0;
 #endif
+                    // Set target direction based on cycle mask and homing cycle approach state.
+                    // NOTE: This happens to compile smaller than any other implementation tried.
+                    if (bit_istrue(settings.homing_dir_mask, bit(axis))) {
+                        if (approach) {
+                            target[axis] = -axis_travel;
+                        } else {
+                            target[axis] = axis_travel;
+                        }
+                    } else {
+                        if (approach) {
+                            target[axis] = axis_travel;
+                        } else {
+                            target[axis] = -axis_travel;
                         }
                     }
                 }
-                sys.homing_axis_lock = axislock;
             }
+            sys.homing_axis_lock = axislock;
 
-            st_prep_buffer();  // Check and prep segment buffer. NOTE: Should take no longer than
-                               // 200us.
+            // Perform homing motion. Planner buffer should be empty, as required to initiate the
+            // homing cycle.
+            pl_data->feed_rate = sqrt(feed_rate_sqr);  // Moves each axis at its own homing rate.
+            plan_buffer_line(target, pl_data);  // Bypass mc_line(). Directly plan homing motion.
 
-            // Exit routines: No time to run protocol_execute_realtime() in this loop.
-            if (sys_rt_exec_state & (EXEC_SAFETY_DOOR | EXEC_RESET | EXEC_CYCLE_STOP)) {
-                uint8_t rt_exec = sys_rt_exec_state;
-                // Homing failure condition: Reset issued during cycle.
-                if (rt_exec & EXEC_RESET) {
-                    system_set_exec_alarm(EXEC_ALARM_HOMING_FAIL_RESET);
-                }
-                // Homing failure condition: Safety door was opened.
-                if (rt_exec & EXEC_SAFETY_DOOR) {
-                    system_set_exec_alarm(EXEC_ALARM_HOMING_FAIL_DOOR);
-                }
-                // Homing failure condition: Limit switch still engaged after pull-off motion
-                if (!approach && (limits_get_state() & cycle_mask)) {
-                    system_set_exec_alarm(EXEC_ALARM_HOMING_FAIL_PULLOFF);
+            sys.step_control = STEP_CONTROL_EXECUTE_SYS_MOTION;  // Set to execute homing motion and
+                                                                 // clear existing flags.
+            st_prep_buffer();  // Prep and fill segment buffer from newly planned block.
+            st_wake_up();      // Initiate motion
+            do {
+                if (approach) {
+                    // Check limit state. Lock out cycle axes when they change.
+#ifdef COREXY
+                    uint8_t limit_state = limits_get_state();
+                    for (axis = 0; axis < N_AXIS; axis++) {
+                        if (axislock & step_mask[axis]) {
+                            if (limit_state & (1 << axis)) {
+                                // Clear the axislock bits to prevent axis from moving after limit is hit
+                                if (axis == Z_AXIS) {
+                                    axislock &= ~(step_mask[Z_AXIS]);
+                                } else {
+                                    axislock &= ~(step_mask[A_MOTOR] | step_mask[B_MOTOR]);
+                                }
+                            }
+                        }
+                    }
+#else
+                    // Clear the axislock bits of each motor on its switch, to prevent it from moving
+                    // after its limit is hit. The motors of a squared axis stop independently.
+                    axislock &= ~limits_get_homed_motors();
+#endif
+                    sys.homing_axis_lock = axislock;
                 }
-                // Homing failure condition: Limit switch not found during approach.
-                if (approach && (rt_exec & EXEC_CYCLE_STOP)) {
-                    system_set_exec_alarm(EXEC_ALARM_HOMING_FAIL_APPROACH);
+
+                st_prep_buffer();  // Check and prep segment buffer. NOTE: Should take no longer than
+                                   // 200us.
+
+                // Exit routines: No time to run protocol_execute_realtime() in this loop.
+                if (sys_rt_exec_state & (EXEC_SAFETY_DOOR | EXEC_RESET | EXEC_CYCLE_STOP)) {
+                    uint8_t rt_exec = sys_rt_exec_state;
+                    // Homing failure condition: Reset issued during cycle.
+                    if (rt_exec & EXEC_RESET) {
+                        system_set_exec_alarm(EXEC_ALARM_HOMING_FAIL_RESET);
+                    }
+                    // Homing failure condition: Safety door was opened.
+                    if (rt_exec & EXEC_SAFETY_DOOR) {
+                        system_set_exec_alarm(EXEC_ALARM_HOMING_FAIL_DOOR);
+                    }
+                    if (sys_rt_exec_alarm) {
+                        mc_reset();  // Stop motors, if they are running.
+                        protocol_execute_realtime();
+                        return;
+                    } else {
+                        // Homing motion complete. Disable CYCLE_STOP from executing.
+                        system_clear_exec_state_flag(EXEC_CYCLE_STOP);
+                        break;
+                    }
                 }
-                if (sys_rt_exec_alarm) {
-                    mc_reset();  // Stop motors, if they are running.
-                    protocol_execute_realtime();
-                    return;
-                } else {
-                    // Pull-off motion complete. Disable CYCLE_STOP from executing.
-                    system_clear_exec_state_flag(EXEC_CYCLE_STOP);
-                    break;
+
+            } while (step::step.mask & axislock);
+
+            st_reset();  // Immediately force kill steppers and reset step segment buffer.
+
+            // Deduct the travel covered by the motion. An axis is done once it has covered its travel,
+            // or has found its switch. The axis that set the motion time has covered its travel exactly.
+            for (axis = 0; axis < N_AXIS; axis++) {
+                if (bit_istrue(pass_mask, bit(axis))) {
+                    if (remaining[axis] / rate[axis] <= cycle_time) {
+                        remaining[axis] = 0.0;
+                    } else {
+                        remaining[axis] -= rate[axis] * cycle_time;
+                    }
+                    if ((remaining[axis] == 0.0) && approach && (axislock & step_mask[axis])) {
+                        pass_mask = 0;  // Switch not found within the search travel. Fails below.
+                        break;
+                    }
+                    if ((remaining[axis] == 0.0) || (approach && !(axislock & step_mask[axis]))) {
+                        bit_false(pass_mask, bit(axis));
+                    }
                 }
             }
+        }
 
-        } while (step::step.mask & axislock);
+        // Homing failure condition: Limit switch not found during approach.
+        if (approach && axislock) {
+            system_set_exec_alarm(EXEC_ALARM_HOMING_FAIL_APPROACH);
+        }
+        // Homing failure condition: Limit switch still engaged after pull-off motion
+        if (!approach && (limits_get_state() & cycle_mask)) {
+            system_set_exec_alarm(EXEC_ALARM_HOMING_FAIL_PULLOFF);
+        }
+        if (sys_rt_exec_alarm) {
+            mc_reset();  // Stop motors, if they are running.
+            protocol_execute_realtime();
+            return;
+        }
 
-        st_reset();  // Immediately force kill steppers and reset step segment buffer.
         delay_ms(
             settings.homing_debounce_delay);  // Delay to allow transient dynamics to dissipate.
 
@@ -279,13 +360,14 @@ void limits_go_home(uint8_t cycle_mask) {
         approach = !approach;
 
         // After first cycle, homing enters locating phase. Shorten search to pull-off distance.
-        if (approach) {
-            max_travel = settings.homing_pulloff * HOMING_AXIS_LOCATE_SCALAR;
-            homing_rate = settings.homing_feed_rate;
-        } else {
-            max_travel = settings.homing_pulloff;
-            homing_rate = settings.homing_seek_rate;
+        for (axis = 0; axis < N_AXIS; axis++) {
+            if (approach) {
+                travel[axis] = settings.homing_pulloff * HOMING_AXIS_LOCATE_SCALAR;
+            } else {
+                travel[axis] = settings.homing_pulloff;
+            }
         }
+        seek = !approach;
 
     } while (n_cycle-- > 0);
 
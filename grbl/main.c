@@ -41,6 +41,9 @@ int main(void)
   // Initialize system upon power-up.
   debug_init();    // Initialize debug LEDs
   isr_init();      // Set ISR priorities (stepper ISR uses Timer1)
+  #ifdef CPU_PROFILE
+    profile_init(); // Start the DWT cycle counter
+  #endif
   delay_init();    // Setup delay timer (uses Timer3)
   serial_init();   // Setup serial baud rate and interrupts
   eeprom_init();   // Init EEPROM or Flash
@@ -92,6 +95,10 @@ int main(void)
     // Reset Grbl primary systems.
     serial_reset_read_buffer(); // Clear serial read buffer
     gc_init();      // Set g-code parser to default state
+    program_init(); // Cancel any incomplete program upload
+    #ifdef LASER_RASTER
+      raster_init(); // Discard queued raster scanlines
+    #endif
     spindle_init(); // Configure spindle pins and PWM values
     coolant_init(); // Configure coolant pins
     limits_init();  // Configure limit input pins and interrupts
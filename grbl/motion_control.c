@@ -22,6 +22,64 @@
 #include "grbl.h"
 
 
+// Waits for room in the planner buffer and queues the line motion.
+static void mc_buffer_line(float *target, plan_line_data_t *pl_data)
+{
+  // If the buffer is full: good! That means we are well ahead of the robot.
+  // Remain in this loop until there is room in the buffer.
+  do {
+    protocol_execute_realtime(); // Check for any run-time commands
+    if (sys.abort) { return; } // Bail, if system abort.
+    if ( plan_check_full_buffer() ) { protocol_auto_cycle_start(); } // Auto-cycle start when buffer is full.
+    else { break; }
+  } while (1);
+
+  // Plan and queue motion into planner buffer
+  // uint8_t plan_status; // Not used in normal operation.
+  plan_buffer_line(target, pl_data);
+}
+
+
+#ifdef HEIGHT_MAP
+  // Queues the line motion offset in Z by the height map. The line is split into segments of up to
+  // HEIGHT_MAP_SEGMENT_LENGTH in the XY plane, each ending at the map height of its XY position. The
+  // start is taken from the planner, less the map offset there. Only Z differs from the line target.
+  static void mc_line_compensated(float *target, plan_line_data_t *pl_data)
+  {
+    float position[N_AXIS];
+    plan_get_planner_mpos(position);
+    position[Z_AXIS] -= heightmap_get_offset(position);
+
+    float delta[N_AXIS];
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) { delta[idx] = target[idx]-position[idx]; }
+    uint16_t segments = ceil(hypot_f(delta[X_AXIS], delta[Y_AXIS])/HEIGHT_MAP_SEGMENT_LENGTH);
+    if (segments == 0) { segments = 1; }
+    #ifdef LASER_RASTER
+      if (pl_data->raster) { segments = 1; } // A scanline must be a single block. Only its end is offset.
+    #endif
+
+    // Each segment of an inverse time motion must take its share of the programmed time.
+    plan_line_data_t segment_data;
+    memcpy(&segment_data, pl_data, sizeof(plan_line_data_t));
+    if (segment_data.condition & PL_COND_FLAG_INVERSE_TIME) { segment_data.feed_rate *= segments; }
+
+    float segment_target[N_AXIS];
+    uint16_t n;
+    for (n=1; n<=segments; n++) {
+      if (n == segments) { memcpy(segment_target, target, sizeof(segment_target)); }
+      else {
+        float t = (float)n/segments;
+        for (idx=0; idx<N_AXIS; idx++) { segment_target[idx] = position[idx]+t*delta[idx]; }
+      }
+      segment_target[Z_AXIS] += heightmap_get_offset(segment_target);
+      mc_buffer_line(segment_target, &segment_data);
+      if (sys.abort) { return; }
+    }
+  }
+#endif
+
+
 // Execute linear motion in absolute millimeter coordinates. Feed rate given in millimeters/second
 // unless invert_feed_rate is true. Then the feed_rate means that the motion should be completed in
 // (1 minute)/feed_rate time.
@@ -55,18 +113,14 @@ void mc_line(float *target, plan_line_data_t *pl_data)
   // doesn't update the machine position values. Since the position values used by the g-code
   // parser and planner are separate from the system machine positions, this is doable.
 
-  // If the buffer is full: good! That means we are well ahead of the robot.
-  // Remain in this loop until there is room in the buffer.
-  do {
-    protocol_execute_realtime(); // Check for any run-time commands
-    if (sys.abort) { return; } // Bail, if system abort.
-    if ( plan_check_full_buffer() ) { protocol_auto_cycle_start(); } // Auto-cycle start when buffer is full.
-    else { break; }
-  } while (1);
+  #ifdef HEIGHT_MAP
+    if (heightmap_is_valid()) {
+      mc_line_compensated(target, pl_data);
+      return;
+    }
+  #endif
 
-  // Plan and queue motion into planner buffer
-  // uint8_t plan_status; // Not used in normal operation.
-  plan_buffer_line(target, pl_data);
+  mc_buffer_line(target, pl_data);
 }
 
 
@@ -185,14 +239,143 @@ void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *of
 
 
 // Execute dwell in seconds.
-void mc_dwell(float seconds)
+#ifdef QUEUE_ACCESSORY_COMMANDS
+  // Queues an event block in the planner buffer. Waits for room in the buffer like mc_line().
+  static void mc_buffer_event(plan_line_data_t *pl_data, uint8_t event, uint32_t dwell)
+  {
+    do {
+      protocol_execute_realtime(); // Check for any run-time commands
+      if (sys.abort) { return; } // Bail, if system abort.
+      if ( plan_check_full_buffer() ) { protocol_auto_cycle_start(); } // Auto-cycle start when buffer is full.
+      else { break; }
+    } while (1);
+    plan_buffer_event(pl_data, event, dwell);
+  }
+
+
+  // Returns true, if there is buffered motion to queue an event behind. Otherwise, it's executed right
+  // away, as it would be after a buffer sync.
+  static uint8_t mc_motion_buffered()
+  {
+    return((plan_get_current_block() != NULL) || (sys.state == STATE_CYCLE));
+  }
+
+
+  // Sets the spindle and coolant state of the block condition, as flagged by the event. Queued in the
+  // planner buffer, so the stepper ISR sets them at this place in the path, without a buffer sync.
+  void mc_update_accessories(plan_line_data_t *pl_data, uint8_t event)
+  {
+    if (sys.state == STATE_CHECK_MODE) { return; }
+    if (mc_motion_buffered()) {
+      mc_buffer_event(pl_data, event, 0);
+    } else {
+      if (event & PL_EVENT_SPINDLE) {
+        spindle_set_state(pl_data->condition & (PL_COND_FLAG_SPINDLE_CW|PL_COND_FLAG_SPINDLE_CCW), pl_data->spindle_speed);
+      }
+      if (event & PL_EVENT_COOLANT) {
+        coolant_set_state(pl_data->condition & (PL_COND_FLAG_COOLANT_FLOOD|PL_COND_FLAG_COOLANT_MIST));
+      }
+    }
+  }
+#endif
+
+
+// Dwell for a specific number of seconds. Queued in the planner buffer as an event that stops motion,
+// if enabled. A zero dwell always syncs the buffer, so interfaces can use it to wait on motion.
+void mc_dwell(float seconds, plan_line_data_t *pl_data)
 {
   if (sys.state == STATE_CHECK_MODE) { return; }
+  #ifdef QUEUE_ACCESSORY_COMMANDS
+    if ((seconds > 0.0) && mc_motion_buffered()) {
+      mc_buffer_event(pl_data, PL_EVENT_STOP, lround(1000.0*seconds));
+      return;
+    }
+  #endif
   protocol_buffer_synchronize();
   delay_sec(seconds, DELAY_MODE_DWELL);
 }
 
 
+// Execute a canned drilling cycle. For each hole, the plane axes rapid to the hole position and the
+// drilling axis rapids down to the R plane, after first rising to it, if below. The hole is then fed
+// to the bottom in one motion (G81,G82) or in pecks (G73,G83), dwells at the bottom (G82), and the
+// drilling axis rapids out to the clear plane. All motions are queued in the planner like any other
+// line motion, so a drilling program streams as one line per hole.
+// NOTE: G83 fully retracts to the R plane after each peck to clear chips, then rapids back down to
+// just above the previous peck depth. G73 only backs off a short distance to break the chip.
+void mc_canned_cycle(float *target, plan_line_data_t *pl_data, float *position, mc_canned_cycle_t *cycle)
+{
+  uint8_t axis_linear = cycle->axis_linear;
+  uint8_t feed_condition = pl_data->condition;
+  uint8_t rapid_condition = feed_condition | PL_COND_FLAG_RAPID_MOTION;
+  uint8_t holes = cycle->repeats;
+  float cycle_target[N_AXIS];
+  float increment[N_AXIS];
+  float depth;
+  uint8_t idx;
+
+  // Plane motion between repeated holes. Holes only move in incremental mode.
+  for (idx=0; idx<N_AXIS; idx++) {
+    if (cycle->incremental && (idx != axis_linear)) { increment[idx] = target[idx]-position[idx]; }
+    else { increment[idx] = 0.0; }
+  }
+
+  // Preliminary motion. Rapid the drilling axis up to the R plane, if it's below it.
+  memcpy(cycle_target,position,sizeof(cycle_target));
+  pl_data->condition = rapid_condition;
+  if (cycle_target[axis_linear] < cycle->r_plane) {
+    cycle_target[axis_linear] = cycle->r_plane;
+    mc_line(cycle_target, pl_data);
+  }
+
+  while (1) {
+    // Rapid to the hole position at the current drilling axis height, then down to the R plane.
+    pl_data->condition = rapid_condition;
+    depth = cycle_target[axis_linear];
+    memcpy(cycle_target,target,sizeof(cycle_target));
+    cycle_target[axis_linear] = depth;
+    mc_line(cycle_target, pl_data);
+    cycle_target[axis_linear] = cycle->r_plane;
+    mc_line(cycle_target, pl_data);
+
+    // Feed to the hole bottom in pecks, or in one motion when there is no peck depth.
+    depth = cycle->r_plane;
+    do {
+      depth -= cycle->peck;
+      if ((cycle->peck == 0.0) || (depth < cycle->bottom)) { depth = cycle->bottom; }
+      pl_data->condition = feed_condition;
+      cycle_target[axis_linear] = depth;
+      mc_line(cycle_target, pl_data);
+      if (depth > cycle->bottom) {
+        pl_data->condition = rapid_condition;
+        if (cycle->motion == MOTION_MODE_DRILL_PECK) {
+          cycle_target[axis_linear] = cycle->r_plane;
+          mc_line(cycle_target, pl_data);
+          cycle_target[axis_linear] = depth+CANNED_CYCLE_PECK_CLEARANCE;
+        } else { // MOTION_MODE_DRILL_CHIP_BREAK
+          cycle_target[axis_linear] = depth+CANNED_CYCLE_CHIP_BREAK_RETRACT;
+        }
+        if (cycle_target[axis_linear] > cycle->r_plane) { cycle_target[axis_linear] = cycle->r_plane; }
+        mc_line(cycle_target, pl_data);
+      }
+      if (sys.abort) { return; } // Bail, if system abort.
+    } while (depth > cycle->bottom);
+
+    // Dwell at the hole bottom, if requested, and rapid out to the clear plane.
+    if (cycle->motion == MOTION_MODE_DRILL_DWELL) { mc_dwell(cycle->dwell, pl_data); }
+    pl_data->condition = rapid_condition;
+    cycle_target[axis_linear] = cycle->clear_plane;
+    mc_line(cycle_target, pl_data);
+    if (sys.abort) { return; } // Bail, if system abort.
+
+    if (--holes == 0) { break; }
+    for (idx=0; idx<N_AXIS; idx++) { target[idx] += increment[idx]; }
+  }
+  target[axis_linear] = cycle->clear_plane;
+  pl_data->condition = feed_condition;
+}
+
+
 // Perform homing cycle to locate and set machine zero. Only '$H' executes this command.
 // NOTE: There should be no motions in the buffer and Grbl must be in an idle state before
 // executing the homing cycle. This prevents incorrect buffered plans after homing.
@@ -246,6 +429,71 @@ void mc_homing_cycle(uint8_t cycle_mask)
 }
 
 
+// Executes a motion of the probe cycle right away and waits until it completes or, if probing, the
+// probe triggers. Returns false upon a system abort.
+static uint8_t mc_probe_motion(float *target, plan_line_data_t *pl_data, uint8_t probing)
+{
+  // Setup and queue probing motion. Auto cycle-start should not start the cycle.
+  mc_line(target, pl_data);
+
+  // Activate the probing state monitor in the stepper module.
+  if (probing) { sys_probe_state = PROBE_ACTIVE; }
+
+  // Perform the motion. Wait here until probe is triggered or motion completes.
+  system_set_exec_state_flag(EXEC_CYCLE_START);
+  do {
+    protocol_execute_realtime();
+    if (sys.abort) { return(false); } // Check for system abort
+  } while (sys.state != STATE_IDLE);
+  return(true);
+}
+
+
+// Second stage of two-stage probing, once the seek at the programmed rate triggered the probe. Retracts
+// from the trigger point towards the start position and probes again at the slow latch rate, which gives
+// the probe position. Returns GC_PROBE_FOUND, once the latch motion completed, or a failure.
+static uint8_t mc_probe_latch(float *target, plan_line_data_t *pl_data, float *start)
+{
+  // Reset the stepper and planner buffers to remove the remainder of the seek motion.
+  st_reset();
+  plan_reset();
+  plan_sync_position();
+
+  // Retract along the probing direction, but never past the start position.
+  float trigger[N_AXIS], retract_target[N_AXIS];
+  probe_get_position(trigger);
+  float distance = 0.0;
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) { distance += (trigger[idx]-start[idx])*(trigger[idx]-start[idx]); }
+  distance = sqrt(distance);
+  if (distance > 0.0) {
+    float retract = std::min(settings.probe_retract, distance)/distance;
+    for (idx=0; idx<N_AXIS; idx++) { retract_target[idx] = trigger[idx]-retract*(trigger[idx]-start[idx]); }
+    #ifdef HEIGHT_MAP
+      // The retract target is a machine position, which already includes the height map offset. Remove
+      // it, since mc_line() adds it again.
+      retract_target[Z_AXIS] -= heightmap_get_offset(retract_target);
+    #endif
+    if (!mc_probe_motion(retract_target, pl_data, false)) { return(GC_PROBE_ABORT); }
+  }
+
+  // The probe must have released to latch it again.
+  if ( probe_get_state() ) {
+    system_set_exec_alarm(EXEC_ALARM_PROBE_FAIL_INITIAL);
+    protocol_execute_realtime();
+    probe_configure_away(false); // Re-initialize invert mask before returning.
+    return(GC_PROBE_FAIL_INIT);
+  }
+
+  plan_line_data_t latch_data;
+  memcpy(&latch_data, pl_data, sizeof(plan_line_data_t));
+  latch_data.feed_rate = settings.probe_latch_rate;
+  latch_data.condition &= ~(PL_COND_FLAG_INVERSE_TIME);
+  if (!mc_probe_motion(target, &latch_data, true)) { return(GC_PROBE_ABORT); }
+  return(GC_PROBE_FOUND);
+}
+
+
 // Perform tool length probe cycle. Requires probe switch.
 // NOTE: Upon probe failure, the program will be stopped and placed into ALARM state.
 uint8_t mc_probe_cycle(float *target, plan_line_data_t *pl_data, uint8_t parser_flags)
@@ -272,18 +520,15 @@ uint8_t mc_probe_cycle(float *target, plan_line_data_t *pl_data, uint8_t parser_
     return(GC_PROBE_FAIL_INIT); // Nothing else to do but bail.
   }
 
-  // Setup and queue probing motion. Auto cycle-start should not start the cycle.
-  mc_line(target, pl_data);
-
-  // Activate the probing state monitor in the stepper module.
-  sys_probe_state = PROBE_ACTIVE;
-
-  // Perform probing cycle. Wait here until probe is triggered or motion completes.
-  system_set_exec_state_flag(EXEC_CYCLE_START);
-  do {
-    protocol_execute_realtime();
-    if (sys.abort) { return(GC_PROBE_ABORT); } // Check for system abort
-  } while (sys.state != STATE_IDLE);
+  // Perform probing cycle. With two-stage probing enabled, this is the seek at the programmed rate,
+  // which is followed by a retract and the latch at the slow rate, if it triggered the probe.
+  float start[N_AXIS];
+  system_convert_array_steps_to_mpos(start, sys_position);
+  if (!mc_probe_motion(target, pl_data, true)) { return(GC_PROBE_ABORT); }
+  if ((settings.probe_latch_rate > 0.0) && !is_probe_away && (sys_probe_state != PROBE_ACTIVE)) {
+    uint8_t status = mc_probe_latch(target, pl_data, start);
+    if (status != GC_PROBE_FOUND) { return(status); }
+  }
 
   // Probing cycle complete!
 
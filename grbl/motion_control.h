@@ -48,8 +48,31 @@ void mc_line(float *target, plan_line_data_t *pl_data);
 void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius,
   uint8_t axis_0, uint8_t axis_1, uint8_t axis_linear, uint8_t is_clockwise_arc);
 
-// Dwell for a specific number of seconds
-void mc_dwell(float seconds);
+// Dwell for a specific number of seconds. Queued in the planner buffer, if QUEUE_ACCESSORY_COMMANDS is enabled.
+void mc_dwell(float seconds, plan_line_data_t *pl_data);
+
+#ifdef QUEUE_ACCESSORY_COMMANDS
+  // Queue the spindle and coolant state of the block condition in the planner buffer, as flagged by the
+  // PL_EVENT flags. Applied by the stepper ISR at this place in the path, without a buffer sync.
+  void mc_update_accessories(plan_line_data_t *pl_data, uint8_t event);
+#endif
+
+// Canned drilling cycle parameters. Drilling axis positions are in absolute machine coordinates.
+typedef struct {
+  uint8_t motion;       // Canned cycle motion mode. {G73,G81,G82,G83}
+  uint8_t axis_linear;  // Drilling axis, normal to the selected plane.
+  uint8_t repeats;      // Number of holes drilled. Repeats step by the plane motion in incremental mode.
+  uint8_t incremental;  // True, if the plane motion of the block is incremental.
+  float r_plane;        // Drilling axis position where feed motion starts and pecks retract to.
+  float bottom;         // Drilling axis position of the hole bottom.
+  float clear_plane;    // Drilling axis position retracted to after each hole.
+  float peck;           // Peck depth. (G73,G83)
+  float dwell;          // Dwell at hole bottom in seconds. (G82)
+} mc_canned_cycle_t;
+
+// Execute a canned drilling cycle to the target hole position. Target is returned with the final
+// position after all repeats.
+void mc_canned_cycle(float *target, plan_line_data_t *pl_data, float *position, mc_canned_cycle_t *cycle);
 
 // Perform homing cycle to locate machine zero. Requires limit switches.
 void mc_homing_cycle(uint8_t cycle_mask);
@@ -25,14 +25,23 @@
 #define MAX_INT_DIGITS 8 // Maximum number of digits in int32 (and float)
 
 
-// Extracts a floating point value from a string. The following code is based loosely on
+// Powers of ten used to scale decimal significands. All entries are exactly representable
+// as floats, so a scaling division is correctly rounded.
+static const uint32_t pow10_table[MAX_INT_DIGITS+1] =
+  { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+
+// Extracts a decimal value from a string into a signed integer significand and a base-10
+// exponent, such that value = significand*10^exponent. The following code is based loosely on
 // the avr-libc strtod() function by Michael Stumpf and Dmitry Xmelkov and many freely
 // available conversion method examples, but has been highly optimized for Grbl. For known
 // CNC applications, the typical decimal value is expected to be in the range of E0 to E-4.
 // Scientific notation is officially not supported by g-code, and the 'E' character may
 // be a g-code word on some CNC systems. So, 'E' notation will not be recognized.
+// NOTE: No floating point math is performed here. Integer command and mantissa values can
+// be derived exactly with decimal_split(), and the float value only when it is needed.
 // NOTE: Thanks to Radu-Eosif Mihailescu for identifying the issues with using strtod().
-uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
+uint8_t read_decimal(char *line, uint8_t *char_counter, int32_t *significand, int8_t *exponent)
 {
   char *ptr = line + *char_counter;
   unsigned char c;
@@ -75,35 +84,67 @@ uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
   // Return if no digits have been read.
   if (!ndigit) { return(false); };
 
-  // Convert integer into floating point.
-  float fval;
-  fval = (float)intval;
+  // Assign significand with correct sign. Fits, since it holds no more than MAX_INT_DIGITS.
+  if (isnegative) {
+    *significand = -(int32_t)intval;
+  } else {
+    *significand = intval;
+  }
+  *exponent = exp;
 
-  // Apply decimal. Should perform no more than two floating point multiplications for the
-  // expected range of E0 to E-4.
-  if (fval != 0) {
-    while (exp <= -2) {
-      fval *= 0.01;
-      exp += 2;
-    }
-    if (exp < 0) {
-      fval *= 0.1;
-    } else if (exp > 0) {
-      do {
-        fval *= 10.0;
-      } while (--exp > 0);
-    }
+  *char_counter = ptr - line - 1; // Set char_counter to next statement
+
+  return(true);
+}
+
+
+// Converts a decimal significand and exponent, as read by read_decimal(), into a float. Values
+// in the expected range of E0 to E-8 are scaled by a single division.
+float decimal_to_float(int32_t significand, int8_t exponent)
+{
+  float fval = (float)significand;
+  if (exponent < 0) {
+    fval /= pow10_table[-exponent];
+  } else {
+    while (exponent-- > 0) { fval *= 10.0; } // Only occurs with more than MAX_INT_DIGITS digits.
   }
+  return(fval);
+}
 
-  // Assign floating point value with correct sign.
-  if (isnegative) {
-    *float_ptr = -fval;
+
+// Splits a decimal, as read by read_decimal(), into the truncated integer part of its magnitude
+// and its first two fractional digits (rounded, 0-100) using integer math only. Integer parts
+// too large for a signed 32-bit value are saturated.
+void decimal_split(int32_t significand, int8_t exponent, uint32_t *int_part, uint16_t *mantissa)
+{
+  uint32_t magnitude = labs(significand);
+  if (exponent >= 0) {
+    while (exponent-- > 0) {
+      if (magnitude > (INT32_MAX/10)) { magnitude = INT32_MAX; break; }
+      magnitude *= 10;
+    }
+    *int_part = magnitude;
+    *mantissa = 0;
   } else {
-    *float_ptr = fval;
+    uint32_t divisor = pow10_table[-exponent];
+    uint32_t fraction = magnitude % divisor;
+    *int_part = magnitude / divisor;
+    if (divisor == 10) { *mantissa = fraction*10; }
+    else if (divisor == 100) { *mantissa = fraction; }
+    else { *mantissa = (fraction + (divisor/200)) / (divisor/100); } // Round to nearest hundredth.
   }
+}
 
-  *char_counter = ptr - line - 1; // Set char_counter to next statement
 
+// Extracts a floating point value from a string. See read_decimal() for the accepted format.
+// Line points to the input buffer, char_counter is the indexer pointing to the current
+// character of the line, while float_ptr is a pointer to the result variable.
+uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
+{
+  int32_t significand;
+  int8_t exponent;
+  if (!read_decimal(line, char_counter, &significand, &exponent)) { return(false); }
+  *float_ptr = decimal_to_float(significand, exponent);
   return(true);
 }
 
@@ -71,6 +71,16 @@
 // a pointer to the result variable. Returns true when it succeeds
 uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr);
 
+// Read a decimal value from a string as a signed integer significand and base-10 exponent,
+// without any floating point math. Same calling convention as read_float().
+uint8_t read_decimal(char *line, uint8_t *char_counter, int32_t *significand, int8_t *exponent);
+
+// Converts a decimal read by read_decimal() into a float.
+float decimal_to_float(int32_t significand, int8_t exponent);
+
+// Splits a decimal read by read_decimal() into its integer magnitude and two-digit mantissa.
+void decimal_split(int32_t significand, int8_t exponent, uint32_t *int_part, uint16_t *mantissa);
+
 // Non-blocking delay function used for general operation and suspend features.
 void delay_sec(float seconds, uint8_t mode);
 
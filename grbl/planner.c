@@ -38,6 +38,7 @@ typedef struct {
                                      // i.e. arcs, canned cycles, and backlash compensation.
   float previous_unit_vec[N_AXIS];   // Unit vector of previous path line segment
   float previous_nominal_speed;  // Nominal speed of previous path line segment
+  float queued_time;             // Sum of the execution times of the blocks in the buffer (min)
 } planner_t;
 static planner_t pl;
 
@@ -124,9 +125,11 @@ static uint8_t plan_prev_block_index(uint8_t block_index)
   to compute an optimal plan, so select carefully. The Arduino 328p memory is already maxed out, but future
   ARM versions should have enough memory and speed for look-ahead blocks numbering up to a hundred or more.
 
+  NOTE: Kept in RAM. Runs over the whole buffer on every new block.
 */
-static void planner_recalculate()
+FASTCODE static void planner_recalculate()
 {
+  PROFILE(PROFILE_PLANNER);
   // Initialize block index to the last block in the planner buffer.
   uint8_t block_index = plan_prev_block_index(block_buffer_head);
 
@@ -211,6 +214,7 @@ void plan_reset_buffer()
   block_buffer_head = 0; // Empty = tail
   next_buffer_head = 1; // plan_next_block_index(block_buffer_head)
   block_buffer_planned = 0; // = block_buffer_tail;
+  pl.queued_time = 0.0;
 }
 
 
@@ -220,7 +224,9 @@ void plan_discard_current_block()
     uint8_t block_index = plan_next_block_index( block_buffer_tail );
     // Push block_buffer_planned pointer, if encountered.
     if (block_buffer_tail == block_buffer_planned) { block_buffer_planned = block_index; }
+    pl.queued_time -= block_buffer[block_buffer_tail].execution_time;
     block_buffer_tail = block_index;
+    if (block_buffer_head == block_buffer_tail) { pl.queued_time = 0.0; } // Clear rounding errors.
   }
 }
 
@@ -233,7 +239,8 @@ plan_block_t *plan_get_system_motion_block()
 
 
 // Returns address of first planner block, if available. Called by various main program functions.
-plan_block_t *plan_get_current_block()
+// NOTE: Kept in RAM, since the stepper ISR also checks for planned motion when it runs out of segments.
+FASTCODE plan_block_t *plan_get_current_block()
 {
   if (block_buffer_head == block_buffer_tail) { return(NULL); } // Buffer empty
   return(&block_buffer[block_buffer_tail]);
@@ -266,11 +273,55 @@ float plan_compute_profile_nominal_speed(plan_block_t *block)
     if (!(block->condition & PL_COND_FLAG_NO_FEED_OVERRIDE)) { nominal_speed *= (0.01*sys.f_override); }
     if (nominal_speed > block->rapid_rate) { nominal_speed = block->rapid_rate; }
   }
+  nominal_speed *= block->slowdown_factor;
   if (nominal_speed > MINIMUM_FEED_RATE) { return(nominal_speed); }
   return(MINIMUM_FEED_RATE);
 }
 
 
+// Computes the execution time of a block from its trapezoidal velocity profile, which accelerates from the
+// entry speed to the nominal speed, cruises, and decelerates to the exit speed. Falls back to a triangle
+// profile, when the block is too short to reach the nominal speed.
+float plan_compute_profile_time(plan_block_t *block, float entry_speed_sqr, float exit_speed_sqr)
+{
+  if (block->step_event_count == 0) { return(block->dwell*(1.0/60000.0)); } // Event block. Dwell only.
+  float nominal_speed = plan_compute_profile_nominal_speed(block);
+  float nominal_speed_sqr = nominal_speed*nominal_speed;
+  float inv_2_accel = 0.5/block->acceleration;
+  float cruise_distance = block->millimeters - (fabs(nominal_speed_sqr-entry_speed_sqr) +
+                          fabs(nominal_speed_sqr-exit_speed_sqr))*inv_2_accel;
+  if (cruise_distance < 0.0) {
+    cruise_distance = 0.0;
+    nominal_speed = sqrt(0.5*(entry_speed_sqr+exit_speed_sqr) + block->acceleration*block->millimeters);
+  }
+  float entry_speed = sqrt(entry_speed_sqr);
+  float exit_speed = sqrt(exit_speed_sqr);
+  return( (fabs(nominal_speed-entry_speed) + fabs(nominal_speed-exit_speed))/block->acceleration +
+          cruise_distance/nominal_speed );
+}
+
+
+// Updates the execution times of the blocks from the given block to the buffer head and the queued time
+// with their change. Called after the plan changed, from the first block whose exit speed may differ.
+static void plan_update_queued_time(uint8_t block_index)
+{
+  plan_block_t *block;
+  float exit_speed_sqr, time;
+  while (block_index != block_buffer_head) {
+    block = &block_buffer[block_index];
+    block_index = plan_next_block_index(block_index);
+    if (block_index == block_buffer_head) { exit_speed_sqr = 0.0; } // Last block plans to a stop.
+    else { exit_speed_sqr = block_buffer[block_index].entry_speed_sqr; }
+    time = plan_compute_profile_time(block, block->entry_speed_sqr, exit_speed_sqr);
+    pl.queued_time += time - block->execution_time;
+    block->execution_time = time;
+  }
+}
+
+
+float plan_get_queued_time() { return(pl.queued_time); }
+
+
 // Computes and updates the max entry speed (sqr) of the block, based on the minimum of the junction's
 // previous and current nominal speeds and max junction speed.
 static void plan_compute_profile_parameters(plan_block_t *block, float nominal_speed, float prev_nominal_speed)
@@ -291,9 +342,11 @@ void plan_update_velocity_profile_parameters()
   float prev_nominal_speed = SOME_LARGE_VALUE; // Set high for first block nominal speed calculation.
   while (block_index != block_buffer_head) {
     block = &block_buffer[block_index];
-    nominal_speed = plan_compute_profile_nominal_speed(block);
-    plan_compute_profile_parameters(block, nominal_speed, prev_nominal_speed);
-    prev_nominal_speed = nominal_speed;
+    if (block->step_event_count) { // Event blocks keep their fixed entry speed limits.
+      nominal_speed = plan_compute_profile_nominal_speed(block);
+      plan_compute_profile_parameters(block, nominal_speed, prev_nominal_speed);
+      prev_nominal_speed = nominal_speed;
+    }
     block_index = plan_next_block_index(block_index);
   }
   pl.previous_nominal_speed = prev_nominal_speed; // Update prev nominal speed for next incoming block.
@@ -326,6 +379,12 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
   #ifdef USE_LINE_NUMBERS
     block->line_number = pl_data->line_number;
   #endif
+  #ifdef LASER_RASTER
+    block->raster = pl_data->raster;
+  #endif
+  #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+    block->wco_generation = sys.wco_generation;
+  #endif
 
   // Compute and store initial move distance data.
   int32_t target_steps[N_AXIS], position_steps[N_AXIS];
@@ -377,7 +436,7 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
     unit_vec[idx] = delta_mm; // Store unit vector numerator
 
     // Set direction bits. Bit enabled always means direction is negative.
-    if (delta_mm < 0.0 ) { block->direction_bits |= step::direction.pins[idx].mask; }
+    if (delta_mm < 0.0 ) { block->direction_bits |= step::direction_masks[idx]; }
   }
 
   // Bail if this is a zero-length block. Highly unlikely to occur.
@@ -398,6 +457,18 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
     if (block->condition & PL_COND_FLAG_INVERSE_TIME) { block->programmed_rate *= block->millimeters; }
   }
 
+  // Slow down new blocks in proportion, when the queued motion time runs low during a cycle. Slower blocks
+  // take longer to execute, so the buffer refills before it runs dry and forces a stop. The factor stays
+  // with the block, so it keeps its speed when overrides or the stepper module recompute it.
+  block->slowdown_factor = 1.0;
+  if ((settings.slowdown_buffer_time > 0.0) && (sys.state == STATE_CYCLE) &&
+      !(block->condition & PL_COND_FLAG_SYSTEM_MOTION)) {
+    float slowdown_factor = st_get_queued_time()*60000.0/settings.slowdown_buffer_time;
+    if (slowdown_factor < 1.0) {
+      block->slowdown_factor = std::max(slowdown_factor, 0.01f*settings.slowdown_min_rate);
+    }
+  }
+
   // TODO: Need to check this method handling zero junction speeds when starting from rest.
   if ((block_buffer_head == block_buffer_tail) || (block->condition & PL_COND_FLAG_SYSTEM_MOTION)) {
 
@@ -464,17 +535,56 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
     memcpy(pl.previous_unit_vec, unit_vec, sizeof(unit_vec)); // pl.previous_unit_vec[] = unit_vec[]
     memcpy(pl.position, target_steps, sizeof(target_steps)); // pl.position[] = target_steps[]
 
+    // Count the planner running empty, while the steppers are still executing motion.
+    if ((block_buffer_head == block_buffer_tail) && (sys.state == STATE_CYCLE)) { st_count_planner_starved(); }
+
     // New block is all set. Update buffer head and next buffer head indices.
     block_buffer_head = next_buffer_head;
     next_buffer_head = plan_next_block_index(block_buffer_head);
 
-    // Finish up by recalculating the plan with the new block.
+    // Finish up by recalculating the plan with the new block. Blocks before the planned pointer keep
+    // their entry and exit speeds, so only the times from there on are updated.
+    uint8_t block_index = block_buffer_planned;
     planner_recalculate();
+    plan_update_queued_time(block_index);
   }
   return(PLAN_OK);
 }
 
 
+// Adds a zero-length event block to the buffer. Events have no length to accelerate over, so the
+// planner carries the speed across them unchanged or, if the event stops motion, plans to a stop at
+// them. The junction of the motions on either side is still limited by the previous motion, since
+// events don't update the previous unit vector and nominal speed.
+// NOTE: Assumes buffer is available, like plan_buffer_line().
+void plan_buffer_event(plan_line_data_t *pl_data, uint8_t event, uint32_t dwell)
+{
+  plan_block_t *block = &block_buffer[block_buffer_head];
+  memset(block,0,sizeof(plan_block_t)); // Zero all block values.
+  block->condition = pl_data->condition;
+  #ifdef VARIABLE_SPINDLE
+    block->spindle_speed = pl_data->spindle_speed;
+  #endif
+  #ifdef USE_LINE_NUMBERS
+    block->line_number = pl_data->line_number;
+  #endif
+  #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+    block->wco_generation = sys.wco_generation;
+  #endif
+  block->event = event;
+  block->dwell = dwell;
+  block->slowdown_factor = 1.0;
+  if (!(event & PL_EVENT_STOP)) { block->max_entry_speed_sqr = block->max_junction_speed_sqr = SOME_LARGE_VALUE; }
+
+  block_buffer_head = next_buffer_head;
+  next_buffer_head = plan_next_block_index(block_buffer_head);
+
+  uint8_t block_index = block_buffer_planned;
+  planner_recalculate();
+  plan_update_queued_time(block_index);
+}
+
+
 // Reset the planner position vectors. Called by the system abort/initialization routine.
 void plan_sync_position()
 {
@@ -497,6 +607,15 @@ void plan_sync_position()
 }
 
 
+// Gets the planner position, which is the end of the last queued motion, in machine coordinates.
+// NOTE: Planner positions are kept in axis steps, also for CoreXY.
+void plan_get_planner_mpos(float *target)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) { target[idx] = pl.position[idx]/settings.steps_per_mm[idx]; }
+}
+
+
 // Returns the number of available blocks are in the planner buffer.
 uint8_t plan_get_block_buffer_available()
 {
@@ -522,4 +641,5 @@ void plan_cycle_reinitialize()
   st_update_plan_block_parameters();
   block_buffer_planned = block_buffer_tail;
   planner_recalculate();
+  plan_update_queued_time(block_buffer_tail);
 }
@@ -48,6 +48,11 @@
 #define PL_COND_MOTION_MASK    (PL_COND_FLAG_RAPID_MOTION|PL_COND_FLAG_SYSTEM_MOTION|PL_COND_FLAG_NO_FEED_OVERRIDE)
 #define PL_COND_ACCESSORY_MASK (PL_COND_FLAG_SPINDLE_CW|PL_COND_FLAG_SPINDLE_CCW|PL_COND_FLAG_COOLANT_FLOOD|PL_COND_FLAG_COOLANT_MIST)
 
+// Define planner event flags. Events are zero-length blocks, executed in order with the motion blocks.
+#define PL_EVENT_SPINDLE  bit(0) // Applies the spindle state of the block condition.
+#define PL_EVENT_COOLANT  bit(1) // Applies the coolant state of the block condition.
+#define PL_EVENT_STOP     bit(2) // Plans motion to a stop at the event.
+
 
 // This struct stores a linear movement of a g-code block motion with its critical "nominal" values
 // are as specified in the source g-code.
@@ -63,6 +68,9 @@ typedef struct {
   #ifdef USE_LINE_NUMBERS
     int32_t line_number;  // Block line number for real-time reporting. Copied from pl_line_data.
   #endif
+  #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+    uint8_t wco_generation; // Work coordinate offset generation for real-time reporting. Copied from sys.
+  #endif
 
   // Fields used by the motion planner to manage acceleration. Some of these values may be updated
   // by the stepper module during execution of special motion cases for replanning purposes.
@@ -77,11 +85,23 @@ typedef struct {
   float max_junction_speed_sqr; // Junction entry speed limit based on direction vectors in (mm/min)^2
   float rapid_rate;             // Axis-limit adjusted maximum rate for this block direction in (mm/min)
   float programmed_rate;        // Programmed rate of this block (mm/min).
+  float slowdown_factor;        // Nominal speed factor, set when queued motion ran low as the block was added.
+
+  // Estimated execution time of the block from its planned velocity profile in (min). Updated whenever
+  // the plan changes and summed into the queued motion time of the planner buffer.
+  float execution_time;
+
+  // Event data. Only set for zero-length event blocks, which have no steps. See plan_buffer_event().
+  uint8_t event;   // Event bitflag variable. See defines above.
+  uint32_t dwell;  // Remaining dwell time of the event in (ms). Updated by the stepper module.
 
   #ifdef VARIABLE_SPINDLE
     // Stored spindle speed data used by spindle overrides and resuming methods.
     float spindle_speed;    // Block spindle speed. Copied from pl_line_data.
   #endif
+  #ifdef LASER_RASTER
+    uint8_t raster;         // Raster scanline number of a scanline block. Copied from pl_line_data.
+  #endif
 } plan_block_t;
 
 
@@ -93,6 +113,9 @@ typedef struct {
   #ifdef USE_LINE_NUMBERS
     int32_t line_number;    // Desired line number to report when executing.
   #endif
+  #ifdef LASER_RASTER
+    uint8_t raster;         // Raster scanline number, numbered from one. Zero, if not a scanline.
+  #endif
 } plan_line_data_t;
 
 
@@ -105,6 +128,10 @@ void plan_reset_buffer(); // Reset buffer only.
 // rate is taken to mean "frequency" and would complete the operation in 1/feed_rate minutes.
 uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data);
 
+// Add a zero-length event block to the buffer, which dwells or applies the spindle and coolant state
+// of the block condition at its place in the path. Buffer checks are handled like plan_buffer_line().
+void plan_buffer_event(plan_line_data_t *pl_data, uint8_t event, uint32_t dwell);
+
 // Called when the current block is no longer needed. Discards the block and makes the memory
 // availible for new blocks.
 void plan_discard_current_block();
@@ -124,6 +151,13 @@ float plan_get_exec_block_exit_speed_sqr();
 // Called by main program during planner calculations and step segment buffer during initialization.
 float plan_compute_profile_nominal_speed(plan_block_t *block);
 
+// Computes the execution time of a block in minutes, from its trapezoidal velocity profile between the
+// given entry and exit speeds. Called by the stepper module to estimate the remainder of the executing block.
+float plan_compute_profile_time(plan_block_t *block, float entry_speed_sqr, float exit_speed_sqr);
+
+// Returns the estimated execution time of all blocks in the planner buffer in minutes.
+float plan_get_queued_time();
+
 // Re-calculates buffered motions profile parameters upon a motion-based override change.
 void plan_update_velocity_profile_parameters();
 
@@ -143,6 +177,7 @@ uint8_t plan_get_block_buffer_count();
 // Returns the status of the block ring buffer. True, if buffer is full.
 uint8_t plan_check_full_buffer();
 
+// Gets the end position of the last queued motion in machine coordinates.
 void plan_get_planner_mpos(float *target);
 
 
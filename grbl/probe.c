@@ -49,6 +49,7 @@ uint8_t probe_get_state() {
 // Monitors probe pin state and records the system position when detected.
 // Called by the stepper ISR per ISR tick.
 // NOTE: This function must be extremely efficient as to not bog down the stepper ISR.
+// NOTE: Not kept in RAM like the rest of the stepper ISR. Flash is never written during probing.
 void probe_state_monitor() {
     if (probe_get_state()) {
         sys_probe_state = PROBE_OFF;
@@ -56,3 +57,39 @@ void probe_state_monitor() {
         bit_true(sys_rt_exec_state, EXEC_MOTION_CANCEL);
     }
 }
+
+// Gets the probe trigger position past the recorded sys_probe_position, in fractions of a step per
+// motor. The Bresenham counter holds how far the ideal line has run past the last step. The pin is
+// polled once per ISR tick, so the trigger is taken halfway into the tick before it was seen.
+static void probe_get_step_offset(probe_steps_t *steps, float *offset) {
+    for (uint8_t idx = 0; idx < N_AXIS; ++idx) {
+        offset[idx] = 0.0;
+        if (steps->step_event_count == 0) { continue; }
+        float event_count = steps->step_event_count;
+        offset[idx] = (steps->counter[idx] - 0.5*(event_count + steps->steps[idx]))/event_count;
+        if (bit_istrue(steps->direction_bits, bit(idx))) { offset[idx] = -offset[idx]; }
+    }
+}
+
+// Gets the last probe trigger position in machine coordinates, with sub-step resolution. Adds the
+// trigger offset between steps to the recorded sys_probe_position.
+void probe_get_position(float *position) {
+    probe_steps_t steps;
+    float offset[N_AXIS];
+    system_convert_array_steps_to_mpos(position, sys_probe_position);
+    st_get_probe_steps(&steps);
+    probe_get_step_offset(&steps, offset);
+    for (uint8_t idx = 0; idx < N_AXIS; ++idx) {
+        #ifdef COREXY
+            if (idx == X_AXIS) {
+                position[idx] += 0.5*(offset[A_MOTOR] + offset[B_MOTOR]) / settings.steps_per_mm[idx];
+                continue;
+            }
+            if (idx == Y_AXIS) {
+                position[idx] += 0.5*(offset[A_MOTOR] - offset[B_MOTOR]) / settings.steps_per_mm[idx];
+                continue;
+            }
+        #endif
+        position[idx] += offset[idx] / settings.steps_per_mm[idx];
+    }
+}
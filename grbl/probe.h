@@ -25,6 +25,15 @@
 #define PROBE_OFF     0 // Probing disabled or not in use. (Must be zero.)
 #define PROBE_ACTIVE  1 // Actively watching the input pin.
 
+// Bresenham state of the segment being executed, as the probe triggered. Recorded by the stepper ISR.
+// Counters and steps are scaled as the ISR executes them, including the AMASS level of the segment.
+typedef struct {
+  uint32_t counter[N_AXIS];
+  uint32_t steps[N_AXIS];
+  uint32_t step_event_count;
+  uint8_t direction_bits;  // Axes moving in the negative direction. Bit per axis index.
+} probe_steps_t;
+
 // Probe pin initialization routine.
 void probe_init();
 
@@ -39,4 +48,8 @@ uint8_t probe_get_state();
 // stepper ISR per ISR tick.
 void probe_state_monitor();
 
+// Gets the last probe trigger position in machine coordinates, interpolated between steps from
+// the stepper state at the trigger. Only valid after the probe triggered.
+void probe_get_position(float *position);
+
 #endif
@@ -0,0 +1,67 @@
+/*
+  profile.c - cycle counting profiler for time critical code
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+#ifdef CPU_PROFILE
+
+static profile_t profiles[N_PROFILE];
+
+
+void profile_init()
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // Enable the DWT unit
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  profile_reset();
+}
+
+
+void profile_reset()
+{
+  __disable_irq();
+  memset(profiles,0,sizeof(profiles));
+  for (uint8_t idx=0; idx<N_PROFILE; idx++) { profiles[idx].min = UINT32_MAX; }
+  __enable_irq();
+}
+
+
+// NOTE: Called by the stepper ISR, so it's kept in RAM like the ISR. Only ever called for a section
+// from a single interrupt level, so the update needs no locking.
+FASTCODE void profile_record(uint8_t section, uint32_t cycles)
+{
+  profile_t *profile = &profiles[section];
+  profile->count++;
+  profile->total += cycles;
+  if (cycles < profile->min) { profile->min = cycles; }
+  if (cycles > profile->max) { profile->max = cycles; }
+  int8_t bucket = (32-__CLZ(cycles)) - PROFILE_HISTOGRAM_MIN_BITS;
+  if (bucket < 0) { bucket = 0; }
+  if (bucket >= PROFILE_HISTOGRAM_SIZE) { bucket = PROFILE_HISTOGRAM_SIZE-1; }
+  profile->histogram[bucket]++;
+}
+
+
+void profile_get(uint8_t section, profile_t *profile)
+{
+  __disable_irq();
+  memcpy(profile,&profiles[section],sizeof(profile_t));
+  __enable_irq();
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+  profile.h - cycle counting profiler for time critical code
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef profile_h
+#define profile_h
+
+#include <stdint.h>
+#include "LPC17xx.h"
+#include "config.h"
+#include "fastcode.h"
+
+// Profiled code sections. Reported in this order by '$T'.
+#define PROFILE_STEPPER_ISR     0 // TIMER1_IRQHandler()
+#define PROFILE_USB_ISR         1 // USB_IRQHandler()
+#define PROFILE_PREP_BUFFER     2 // st_prep_buffer()
+#define PROFILE_PLANNER         3 // planner_recalculate()
+#define PROFILE_GCODE           4 // gc_execute_line()
+#define PROFILE_STATUS_REPORT   5 // report_realtime_status()
+#define N_PROFILE               6
+
+// Histogram of execution times. Bucket 0 counts times below 2^PROFILE_HISTOGRAM_MIN_BITS cycles. Each
+// following bucket doubles the limit. The last bucket counts everything above.
+#define PROFILE_HISTOGRAM_SIZE      10
+#define PROFILE_HISTOGRAM_MIN_BITS  8
+
+typedef struct {
+  uint32_t count;
+  uint32_t min;   // Cycles
+  uint32_t max;   // Cycles
+  uint64_t total; // Cycles
+  uint32_t histogram[PROFILE_HISTOGRAM_SIZE];
+} profile_t;
+
+#ifdef CPU_PROFILE
+  // Starts the DWT cycle counter and clears all statistics.
+  void profile_init();
+
+  // Clears all statistics. ($TR)
+  void profile_reset();
+
+  // Adds one execution of a section to its statistics.
+  void profile_record(uint8_t section, uint32_t cycles);
+
+  // Gets a consistent copy of the statistics of a section.
+  void profile_get(uint8_t section, profile_t *profile);
+
+  // Times the rest of the enclosing scope, including all its return paths.
+  class ProfileScope {
+    public:
+      __attribute__((always_inline)) ProfileScope(uint8_t section) : section(section), start(DWT->CYCCNT) {}
+      __attribute__((always_inline)) ~ProfileScope() { profile_record(section, DWT->CYCCNT-start); }
+    private:
+      uint8_t section;
+      uint32_t start;
+  };
+  #define PROFILE(section) ProfileScope profile_scope(section)
+#else
+  #define PROFILE(section) // Compiled out
+#endif
+
+#endif
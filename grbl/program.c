@@ -0,0 +1,162 @@
+/*
+  program.c - g-code program storage and local execution
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+#define PROGRAM_MAGIC 0x4D524750 // "PGRM"
+
+// Program header stored in the first page of the region. Lines are stored after it as a sequence of
+// zero-terminated strings in the pre-parsed form received by the protocol. No comments, whitespace, or
+// lowercase letters remain, so they are passed to the g-code parser as-is.
+typedef struct {
+  uint32_t magic;     // Set only when a complete program is stored.
+  uint32_t lines;     // Number of stored lines.
+  uint32_t size;      // Size of the stored line data in bytes, including terminations.
+  uint32_t checksum;  // Checksum of the stored line data.
+} program_header_t;
+
+// Upload state. Line data is buffered one page at a time and written when the page is full.
+static struct {
+  uint8_t uploading;
+  uint16_t page_fill;   // Bytes buffered in the current page.
+  uint32_t offset;      // Region offset of the current page.
+  uint32_t lines;
+  uint32_t checksum;
+  char page[PROGRAM_PAGE_SIZE] __attribute__((aligned(4)));
+} prog;
+
+
+static uint32_t program_checksum_add(uint32_t checksum, char c)
+{
+  return(((checksum << 1) | (checksum >> 31)) + (uint8_t)c);
+}
+
+
+// Returns the stored program header, if it describes a complete and intact program.
+static const program_header_t *program_get_header()
+{
+  const program_header_t *header = (const program_header_t *)program_flash_memory();
+  if (header->magic != PROGRAM_MAGIC) { return(NULL); }
+  if (header->size > (program_flash_size()-PROGRAM_PAGE_SIZE)) { return(NULL); }
+  const char *data = program_flash_memory()+PROGRAM_PAGE_SIZE;
+  uint32_t checksum = 0;
+  for (uint32_t idx=0; idx<header->size; idx++) { checksum = program_checksum_add(checksum,data[idx]); }
+  if (checksum != header->checksum) { return(NULL); }
+  return(header);
+}
+
+
+void program_init()
+{
+  prog.uploading = false;
+}
+
+
+uint8_t program_is_uploading() { return(prog.uploading); }
+
+
+uint8_t program_upload_begin()
+{
+  prog.uploading = false;
+  if (!program_flash_erase()) { return(STATUS_PROGRAM_FLASH_FAIL); }
+  prog.uploading = true;
+  prog.page_fill = 0;
+  prog.offset = PROGRAM_PAGE_SIZE; // Header page is written last.
+  prog.lines = 0;
+  prog.checksum = 0;
+  return(STATUS_OK);
+}
+
+
+uint8_t program_upload_line(char *line)
+{
+  // Check the line and its termination fit in the region, ahead of the header page.
+  uint8_t length = strlen(line)+1;
+  if ((prog.offset+prog.page_fill+length) > program_flash_size()) { return(STATUS_PROGRAM_STORAGE_FULL); }
+  prog.lines++;
+  do {
+    prog.checksum = program_checksum_add(prog.checksum,*line);
+    prog.page[prog.page_fill++] = *line;
+    if (prog.page_fill == PROGRAM_PAGE_SIZE) {
+      if (!program_flash_write(prog.offset,prog.page)) {
+        prog.uploading = false;
+        return(STATUS_PROGRAM_FLASH_FAIL);
+      }
+      prog.offset += PROGRAM_PAGE_SIZE;
+      prog.page_fill = 0;
+    }
+  } while (*line++ != 0);
+  return(STATUS_OK);
+}
+
+
+uint8_t program_upload_end()
+{
+  if (!prog.uploading) { return(STATUS_PROGRAM_INVALID); }
+  prog.uploading = false;
+
+  // Write the last partial page, padded as erased flash.
+  uint32_t size = prog.offset+prog.page_fill-PROGRAM_PAGE_SIZE;
+  if (prog.page_fill) {
+    memset(prog.page+prog.page_fill,0xFF,PROGRAM_PAGE_SIZE-prog.page_fill);
+    if (!program_flash_write(prog.offset,prog.page)) { return(STATUS_PROGRAM_FLASH_FAIL); }
+  }
+
+  // Write the header page. Marks the program as complete.
+  program_header_t header = { PROGRAM_MAGIC, prog.lines, size, prog.checksum };
+  memset(prog.page,0xFF,PROGRAM_PAGE_SIZE);
+  memcpy(prog.page,&header,sizeof(program_header_t));
+  if (!program_flash_write(0,prog.page)) { return(STATUS_PROGRAM_FLASH_FAIL); }
+  return(STATUS_OK);
+}
+
+
+// Executes the stored program, feeding each line straight to the g-code parser. The planner buffer is
+// kept full by the parser, while realtime commands are handled as they are for streamed lines. Stops
+// on the first line with an error, which is reported with its program line number.
+uint8_t program_execute(char *line)
+{
+  const program_header_t *header = program_get_header();
+  if (header == NULL) { return(STATUS_PROGRAM_INVALID); }
+  const char *data = program_flash_memory()+PROGRAM_PAGE_SIZE;
+  uint32_t line_number = 0;
+  uint8_t status;
+  while (line_number < header->lines) {
+    line_number++;
+    strcpy(line,data); // NOTE: Stored lines never exceed the line buffer they were received in.
+    data += strlen(line)+1;
+    protocol_execute_realtime(); // Runtime command check point.
+    if (sys.abort) { return(STATUS_OK); } // Bail, if system abort.
+    status = gc_execute_line(line);
+    if (status) {
+      report_program_line(line_number,line);
+      return(status);
+    }
+  }
+  return(STATUS_OK);
+}
+
+
+uint8_t program_get_info(uint32_t *lines, uint32_t *size)
+{
+  const program_header_t *header = program_get_header();
+  if (header == NULL) { return(false); }
+  *lines = header->lines;
+  *size = header->size;
+  return(true);
+}
@@ -0,0 +1,55 @@
+/*
+  program.h - g-code program storage and local execution
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef program_h
+#define program_h
+
+
+// Program storage is written in pages of this size. The first page of the storage region holds the
+// program header, which is only written once the upload is complete. Line data follows it.
+#define PROGRAM_PAGE_SIZE 256
+
+// Program storage region. Implemented by the port in flash.cpp, which reserves the flash region.
+// The region is memory-mapped for reading. Pages are written at offsets from the region start.
+uint32_t program_flash_size();
+const char *program_flash_memory();
+uint8_t program_flash_erase();
+uint8_t program_flash_write(uint32_t offset, char *page);
+
+// Resets the upload state. Called upon a system abort, which cancels an incomplete upload.
+void program_init();
+
+// Returns true, while received lines are being stored into the program rather than executed.
+uint8_t program_is_uploading();
+
+// Erases the stored program and starts storing received lines. ($PW)
+uint8_t program_upload_begin();
+
+// Appends a received, pre-parsed line to the program being uploaded.
+uint8_t program_upload_line(char *line);
+
+// Completes the upload and marks the stored program as valid. ($PE)
+uint8_t program_upload_end();
+
+// Executes the stored program through the g-code parser. Uses the passed line buffer. ($PR)
+uint8_t program_execute(char *line);
+
+// Gets the stored program line count and size. Returns false, if no valid program is stored.
+uint8_t program_get_info(uint32_t *lines, uint32_t *size);
+
+#endif
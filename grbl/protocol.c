@@ -32,6 +32,12 @@ static char line[LINE_BUFFER_SIZE]; // Line to be executed. Zero-terminated.
 
 static void protocol_exec_rt_suspend();
 
+#ifdef ENABLE_CYCLE_START_GATE
+  static uint32_t rx_time;                 // Time the last serial character was received, in CPU cycles.
+  static uint8_t cycle_start_gate_bypass;  // Set by a '%' line to start the queued motion right away.
+  static uint8_t protocol_cycle_start_gate();
+#endif
+
 
 /*
   GRBL PRIMARY LOOP:
@@ -77,6 +83,9 @@ void protocol_main_loop()
     // Process one line of incoming serial data, as the data becomes available. Performs an
     // initial filtering by removing spaces and comments and capitalizing all letters.
     while((c = serial_read()) != SERIAL_NO_DATA) {
+      #ifdef ENABLE_CYCLE_START_GATE
+        rx_time = get_time();
+      #endif
       if ((c == '\n') || (c == '\r')) { // End of line reached
 
         protocol_execute_realtime(); // Runtime command check point.
@@ -97,6 +106,9 @@ void protocol_main_loop()
         } else if (line[0] == '$') {
           // Grbl '$' system command
           report_status_message(system_execute_line(line));
+        } else if (program_is_uploading()) {
+          // Store line into the program being uploaded. Not executed.
+          report_status_message(program_upload_line(line));
         } else if (sys.state & (STATE_ALARM | STATE_JOG)) {
           // Everything else is gcode. Block if in alarm or jog mode.
           report_status_message(STATUS_SYSTEM_GC_LOCK);
@@ -132,13 +144,12 @@ void protocol_main_loop()
           } else if (c == ';') {
             // NOTE: ';' comment to EOL is a LinuxCNC definition. Not NIST.
             line_flags |= LINE_FLAG_COMMENT_SEMICOLON;
-          // TODO: Install '%' feature
-          // } else if (c == '%') {
-            // Program start-end percent sign NOT SUPPORTED.
-            // NOTE: This maybe installed to tell Grbl when a program is running vs manual input,
-            // where, during a program, the system auto-cycle start will continue to execute
-            // everything until the next '%' sign. This will help fix resuming issues with certain
-            // functions that empty the planner buffer to execute its task on-time.
+          } else if (c == '%') {
+            // Program start-end percent sign. Otherwise ignored, like a comment. At the end of a program,
+            // no more motion follows to look ahead to, so it opens the cycle start gate for the queued moves.
+            #ifdef ENABLE_CYCLE_START_GATE
+              if (plan_get_current_block() != NULL) { cycle_start_gate_bypass = true; }
+            #endif
           } else if (char_counter >= (LINE_BUFFER_SIZE-1)) {
             // Detect line buffer overflow and set flag.
             line_flags |= LINE_FLAG_OVERFLOW;
@@ -155,10 +166,17 @@ void protocol_main_loop()
     // If there are no more characters in the serial read buffer to be processed and executed,
     // this indicates that g-code streaming has either filled the planner buffer or has
     // completed. In either case, auto-cycle start, if enabled, any queued moves.
-    protocol_auto_cycle_start();
+    #ifdef ENABLE_CYCLE_START_GATE
+      if (protocol_cycle_start_gate()) { protocol_auto_cycle_start(); }
+    #else
+      protocol_auto_cycle_start();
+    #endif
 
     protocol_execute_realtime();  // Runtime command check point.
     if (sys.abort) { return; } // Bail to main() program loop to reset system.
+
+    // Nothing left to execute. Commit any flash writes held off during motion.
+    if (sys.state == STATE_IDLE) { settings_commit_deferred(); }
   }
 
   return; /* Never reached */
@@ -192,6 +210,23 @@ void protocol_auto_cycle_start()
 }
 
 
+#ifdef ENABLE_CYCLE_START_GATE
+  // Returns true, when the main loop may auto-cycle start the queued moves. Starting from idle, waits
+  // for enough motion to look ahead, unless the stream stopped or a '%' marked a program boundary.
+  static uint8_t protocol_cycle_start_gate()
+  {
+    if (sys.state != STATE_IDLE) {
+      cycle_start_gate_bypass = false; // Bypass only applies to the next cycle start from idle.
+      return(true);
+    }
+    if (cycle_start_gate_bypass) { return(true); }
+    if ((BLOCK_BUFFER_SIZE-1)-plan_get_block_buffer_available() >= CYCLE_START_GATE_BLOCKS) { return(true); }
+    if (st_get_queued_time()*60000.0 >= CYCLE_START_GATE_TIME) { return(true); }
+    return((get_time()-rx_time) >= (SystemCoreClock/1000)*CYCLE_START_GATE_IDLE_TIME);
+  }
+#endif
+
+
 // This function is the general interface to Grbl's real-time command execution system. It is called
 // from various check points in the main program, primarily where there may be a while loop waiting
 // for a buffer to clear space or any point where the execution time from the last check point may
@@ -446,8 +481,11 @@ void protocol_exec_rt_system()
     last_s_override = std::max(last_s_override, (uint8_t)MIN_SPINDLE_SPEED_OVERRIDE);
 
     if (last_s_override != sys.spindle_speed_ovr) {
-      bit_true(sys.step_control, STEP_CONTROL_UPDATE_SPINDLE_PWM);
       sys.spindle_speed_ovr = last_s_override;
+      #ifdef VARIABLE_SPINDLE
+        spindle_update_pwm_lut();
+      #endif
+      bit_true(sys.step_control, STEP_CONTROL_UPDATE_SPINDLE_PWM);
       sys.report_ovr_counter = 0; // Set to report change immediately
     }
 
@@ -0,0 +1,159 @@
+/*
+  raster.c - raster scanlines for laser engraving
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+#ifdef LASER_RASTER
+
+// Scanline ring buffer. Scanlines are queued in order by the protocol and released in order by the
+// stepper ISR, as their planner blocks complete. Each counter is written by one side only, so no
+// locking is needed, and their difference is the number of buffers in use.
+static uint8_t raster_pixels[RASTER_BUFFER_SIZE][RASTER_MAX_PIXELS];
+static uint16_t raster_count[RASTER_BUFFER_SIZE];
+static uint8_t raster_head;              // Buffer of the pending scanline.
+static uint16_t raster_pending;          // Pixels of the pending scanline.
+static uint8_t raster_queued;            // Scanlines queued. Written by the protocol.
+static volatile uint8_t raster_released; // Scanlines released. Written by the stepper ISR.
+
+
+void raster_init()
+{
+  raster_head = 0;
+  raster_pending = 0;
+  raster_queued = 0;
+  raster_released = 0;
+}
+
+
+static int8_t raster_hex_value(char c)
+{
+  if ((c >= '0') && (c <= '9')) { return(c-'0'); }
+  if ((c >= 'A') && (c <= 'F')) { return(c-'A'+10); }
+  return(-1);
+}
+
+
+uint8_t raster_add_pixels(char *hex)
+{
+  // Wait for the stepper ISR to free a buffer, the same as motions wait for the planner buffer.
+  if (raster_pending == 0) {
+    while ((uint8_t)(raster_queued-raster_released) >= RASTER_BUFFER_SIZE) {
+      protocol_execute_realtime(); // Check for any run-time commands
+      if (sys.abort) { return(STATUS_OK); } // Bail, if system abort.
+      protocol_auto_cycle_start(); // Auto-cycle start, since the queued scanlines fill the buffers.
+    }
+  }
+
+  // A bad pixel discards the whole scanline, so a partial scanline is never run.
+  uint8_t *pixels = raster_pixels[raster_head];
+  while (*hex != 0) {
+    if (raster_pending == RASTER_MAX_PIXELS) {
+      raster_pending = 0;
+      return(STATUS_OVERFLOW);
+    }
+    int8_t high = raster_hex_value(*hex++);
+    int8_t low = raster_hex_value(*hex);
+    if ((high < 0) || (low < 0)) {
+      raster_pending = 0;
+      return(STATUS_BAD_NUMBER_FORMAT);
+    }
+    hex++;
+    pixels[raster_pending++] = (high << 4) | low;
+  }
+  return(STATUS_OK);
+}
+
+
+uint8_t raster_execute(uint8_t axis, float pitch)
+{
+  uint16_t count = raster_pending;
+  raster_pending = 0; // The scanline is run or discarded.
+  if (count == 0) { return(STATUS_INVALID_STATEMENT); }
+  if (bit_isfalse(settings.flags,BITFLAG_LASER_MODE)) { return(STATUS_SETTING_DISABLED); }
+  if ((gc_state.modal.feed_rate == FEED_RATE_MODE_INVERSE_TIME) || (gc_state.feed_rate == 0.0)) {
+    return(STATUS_GCODE_UNDEFINED_FEED_RATE);
+  }
+
+  // Pixels must be at least a step long, so every pixel is burnt and the scanline has steps to run.
+  if (gc_state.modal.units == UNITS_MODE_INCHES) { pitch *= MM_PER_INCH; }
+  float length = count*pitch;
+  if (fabs(length)*settings.steps_per_mm[axis] < count) { return(STATUS_INVALID_STATEMENT); }
+
+  float target[N_AXIS];
+  memcpy(target, gc_state.position, sizeof(target));
+  target[axis] += length;
+
+  // The scanline runs at the programmed feed rate, with the modal spindle and coolant state. Its
+  // pixel powers are scaled by the programmed spindle speed.
+  plan_line_data_t pl_data;
+  memset(&pl_data,0,sizeof(plan_line_data_t));
+  pl_data.feed_rate = gc_state.feed_rate;
+  pl_data.spindle_speed = gc_state.spindle_speed;
+  pl_data.condition = (gc_state.modal.spindle | gc_state.modal.coolant);
+
+  #ifdef RASTER_OVERSCAN
+    // Lead in and out of the scanline with the laser off, over the distance to accelerate to the feed
+    // rate, so the pixels are only burnt at the feed rate. The lead-in start is reached by a rapid.
+    float overscan = (gc_state.feed_rate*gc_state.feed_rate)/(2*settings.acceleration[axis]);
+    if (pitch < 0.0) { overscan = -overscan; }
+    float lead_target[N_AXIS];
+    plan_line_data_t lead_data;
+    memset(&lead_data,0,sizeof(plan_line_data_t));
+    lead_data.feed_rate = gc_state.feed_rate;
+    lead_data.condition = (PL_COND_FLAG_RAPID_MOTION | gc_state.modal.coolant);
+    memcpy(lead_target, gc_state.position, sizeof(lead_target));
+    lead_target[axis] -= overscan;
+    mc_line(lead_target, &lead_data);
+    lead_data.condition = gc_state.modal.coolant;
+    mc_line(gc_state.position, &lead_data);
+    if (sys.abort) { return(STATUS_OK); } // Bail, if system abort.
+  #endif
+
+  // Queue the buffer before the motion, which the stepper ISR may complete right away.
+  if (sys.state != STATE_CHECK_MODE) {
+    raster_count[raster_head] = count;
+    pl_data.raster = raster_head+1;
+    if (++raster_head == RASTER_BUFFER_SIZE) { raster_head = 0; }
+    raster_queued++;
+  }
+  mc_line(target, &pl_data);
+
+  #ifdef RASTER_OVERSCAN
+    // The scanline ends at the lead-out end, past its last pixel. The parser position follows, so it
+    // stays in sync with the planner for the next motion.
+    target[axis] += overscan;
+    mc_line(target, &lead_data);
+  #endif
+  memcpy(gc_state.position, target, sizeof(target));
+  return(STATUS_OK);
+}
+
+
+const uint8_t *raster_get_pixels(uint8_t scanline, uint16_t *count)
+{
+  *count = raster_count[scanline-1];
+  return(raster_pixels[scanline-1]);
+}
+
+
+FASTCODE void raster_release()
+{
+  raster_released++;
+}
+
+#endif
@@ -0,0 +1,43 @@
+/*
+  raster.h - raster scanlines for laser engraving
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef raster_h
+#define raster_h
+
+#ifdef LASER_RASTER
+  // Discards the pending and queued scanlines. Called upon a system abort, which clears the planner.
+  void raster_init();
+
+  // Appends hex encoded pixel powers, two digits per pixel, to the pending scanline. Waits for a free
+  // scanline buffer, if it is the first data of the scanline. ($B=)
+  uint8_t raster_add_pixels(char *hex);
+
+  // Runs the pending scanline along the axis, from the current position, with the pixels spaced by the
+  // pitch. A negative pitch runs the scanline in the negative direction. ($BX=, $BY=)
+  uint8_t raster_execute(uint8_t axis, float pitch);
+
+  // Returns the pixels and pixel count of a queued scanline, by its planner block scanline number.
+  // Called by the step segment generator.
+  const uint8_t *raster_get_pixels(uint8_t scanline, uint16_t *count);
+
+  // Frees the buffer of the oldest queued scanline. Called by the stepper ISR, when the last step of
+  // the scanline is done.
+  void raster_release();
+#endif
+
+#endif
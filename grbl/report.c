@@ -207,6 +207,10 @@ void report_grbl_settings() {
   report_util_float_setting(34,settings.spindle_pwm_off_value,N_DECIMAL_SETTINGVALUE);
   report_util_float_setting(35,settings.spindle_pwm_min_value,N_DECIMAL_SETTINGVALUE);
   report_util_float_setting(36,settings.spindle_pwm_max_value,N_DECIMAL_SETTINGVALUE);
+  report_util_float_setting(40,settings.slowdown_buffer_time,N_DECIMAL_SETTINGVALUE);
+  report_util_uint8_setting(41,settings.slowdown_min_rate);
+  report_util_float_setting(42,settings.probe_latch_rate,N_DECIMAL_SETTINGVALUE);
+  report_util_float_setting(43,settings.probe_retract,N_DECIMAL_SETTINGVALUE);
   // Print axis settings
   uint8_t idx, set_idx;
   uint8_t val = AXIS_SETTINGS_START_VAL;
@@ -218,6 +222,8 @@ void report_grbl_settings() {
         case 2: report_util_float_setting(val+idx,settings.acceleration[idx]/(60*60),N_DECIMAL_SETTINGVALUE); break;
         case 3: report_util_float_setting(val+idx,-settings.max_travel[idx],N_DECIMAL_SETTINGVALUE); break;
         case 4: report_util_float_setting(val+idx,settings.current[idx],N_DECIMAL_SETTINGVALUE); break;
+        case 5: report_util_float_setting(val+idx,settings.axis_homing_seek_rate[idx],N_DECIMAL_SETTINGVALUE); break;
+        case 6: report_util_float_setting(val+idx,settings.axis_homing_feed_rate[idx],N_DECIMAL_SETTINGVALUE); break;
       }
     }
     val += AXIS_SETTINGS_INCREMENT;
@@ -233,7 +239,8 @@ void report_probe_parameters()
   // Report in terms of machine position.
   printPgmString(PSTR("[PRB:"));
   float print_position[N_AXIS];
-  system_convert_array_steps_to_mpos(print_position,sys_probe_position);
+  if (sys.probe_succeeded) { probe_get_position(print_position); }
+  else { system_convert_array_steps_to_mpos(print_position,sys_probe_position); }
   report_util_axis_values(print_position);
   serial_write(':');
   print_uint8_base10(sys.probe_succeeded);
@@ -297,6 +304,9 @@ void report_gcode_modes()
   report_util_gcode_modes_G();
   print_uint8_base10(94-gc_state.modal.feed_rate);
 
+  report_util_gcode_modes_G();
+  print_uint8_base10(98+gc_state.modal.retract);
+
   if (gc_state.modal.program_flow) {
     report_util_gcode_modes_M();
     switch (gc_state.modal.program_flow) {
@@ -435,6 +445,136 @@ void report_build_info(char *line)
 }
 
 
+// Prints stored program line count and size. Both are zero, if no valid program is stored.
+void report_program_info()
+{
+  uint32_t lines, size;
+  if (!program_get_info(&lines,&size)) { lines = 0; size = 0; }
+  printPgmString(PSTR("[PRG:"));
+  print_uint32_base10(lines);
+  serial_write(',');
+  print_uint32_base10(size);
+  report_util_feedback_line_feed();
+}
+
+// Prints the stored program line number and line, which stopped the program with an error.
+void report_program_line(uint32_t n, char *line)
+{
+  printPgmString(PSTR("[PRGERR:"));
+  print_uint32_base10(n);
+  serial_write(',');
+  printString(line);
+  report_util_feedback_line_feed();
+}
+
+
+#ifdef HEIGHT_MAP
+  // Prints the height map grid and heights. The first line holds the grid point counts, and the
+  // origin and spacing in machine coordinates. One line of heights follows per grid row along X.
+  void report_heightmap()
+  {
+    const heightmap_t *hmap = heightmap_get();
+    uint8_t n_points[2] = { 0, 0 };
+    if (hmap->valid) { memcpy(n_points, hmap->n_points, sizeof(n_points)); }
+    printPgmString(PSTR("[HM:"));
+    print_uint8_base10(n_points[X_AXIS]);
+    serial_write(',');
+    print_uint8_base10(n_points[Y_AXIS]);
+    if (hmap->valid) {
+      uint8_t idx;
+      for (idx=X_AXIS; idx<=Y_AXIS; idx++) {
+        serial_write(',');
+        printFloat_CoordValue(hmap->origin[idx]);
+      }
+      for (idx=X_AXIS; idx<=Y_AXIS; idx++) {
+        serial_write(',');
+        printFloat_CoordValue(hmap->spacing[idx]);
+      }
+    }
+    report_util_feedback_line_feed();
+    uint8_t x, y;
+    for (y=0; y<n_points[Y_AXIS]; y++) {
+      printPgmString(PSTR("[HMZ:"));
+      for (x=0; x<n_points[X_AXIS]; x++) {
+        if (x) { serial_write(','); }
+        printFloat_CoordValue(hmap->height[y][x]);
+      }
+      report_util_feedback_line_feed();
+    }
+  }
+#endif
+
+
+#ifdef GC_LINE_CACHE_SIZE
+  // Prints g-code parser line cache hit and miss counters
+  void report_line_cache_counters()
+  {
+    uint32_t hits, misses;
+    gc_get_line_cache_counters(&hits,&misses);
+    printPgmString(PSTR("[LC:"));
+    print_uint32_base10(hits);
+    serial_write(',');
+    print_uint32_base10(misses);
+    report_util_feedback_line_feed();
+  }
+#endif
+
+
+// Prints the segment buffer underrun and planner starvation counters, followed by the least motion
+// time left in the segment buffer in milliseconds. Empty, until measured during a cycle.
+static void report_util_underrun_values()
+{
+  st_underrun_t underruns;
+  st_get_underruns(&underruns);
+  print_uint32_base10(underruns.segment_underruns);
+  serial_write(',');
+  print_uint32_base10(underruns.planner_starved);
+  serial_write(',');
+  if (underruns.min_buffered_valid) { print_uint32_base10(underruns.min_buffered_ms); }
+}
+
+
+// Prints the starvation counters. [U:underruns,starved,min_ms]
+void report_underruns()
+{
+  printPgmString(PSTR("[U:"));
+  report_util_underrun_values();
+  report_util_feedback_line_feed();
+}
+
+
+#ifdef CPU_PROFILE
+  // Prints the profiled sections, one per line, after the CPU clock. Times are in CPU cycles.
+  // [T:name,count,min,avg,max,histogram...]
+  void report_profile()
+  {
+    static const char *const names[N_PROFILE] = { "STEP", "USB", "PREP", "PLAN", "GC", "RPT" };
+    profile_t profile;
+    printPgmString(PSTR("[T:CLK,"));
+    print_uint32_base10(SystemCoreClock);
+    report_util_feedback_line_feed();
+    for (uint8_t section=0; section<N_PROFILE; section++) {
+      profile_get(section,&profile);
+      printPgmString(PSTR("[T:"));
+      printString(names[section]);
+      serial_write(',');
+      print_uint32_base10(profile.count);
+      serial_write(',');
+      print_uint32_base10(profile.count ? profile.min : 0);
+      serial_write(',');
+      print_uint32_base10(profile.count ? (uint32_t)(profile.total/profile.count) : 0);
+      serial_write(',');
+      print_uint32_base10(profile.max);
+      for (uint8_t idx=0; idx<PROFILE_HISTOGRAM_SIZE; idx++) {
+        serial_write(',');
+        print_uint32_base10(profile.histogram[idx]);
+      }
+      report_util_feedback_line_feed();
+    }
+  }
+#endif
+
+
 // Prints the character string line Grbl has received from the user, which has been pre-parsed,
 // and has been sent into protocol_execute_line() routine to be executed by Grbl.
 void report_echo_line_received(char *line)
@@ -451,6 +591,7 @@ void report_echo_line_received(char *line)
  // especially during g-code programs with fast, short line segments and high frequency reports (5-20Hz).
 void report_realtime_status()
 {
+  PROFILE(PROFILE_STATUS_REPORT);
   uint8_t idx;
   int32_t current_position[N_AXIS]; // Copy current state of the system position variable
   memcpy(current_position,sys_position,sizeof(sys_position));
@@ -492,17 +633,21 @@ void report_realtime_status()
     case STATE_SLEEP: printPgmString(PSTR("Sleep")); break;
   }
 
+  // Apply work coordinate offsets and tool length offset of the executing block to current position.
   float wco[N_AXIS];
-  if (bit_isfalse(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE) ||
-      (sys.report_wco_counter == 0) ) {
-    for (idx=0; idx< N_AXIS; idx++) {
-      // Apply work coordinate offsets and tool length offset to current position.
-      wco[idx] = gc_state.coord_system[idx]+gc_state.coord_offset[idx];
-      if (idx == TOOL_LENGTH_OFFSET_AXIS) { wco[idx] += gc_state.tool_length_offset; }
-      if (bit_isfalse(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE)) {
-        print_position[idx] -= wco[idx];
-      }
+  #ifdef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+    system_get_wco(wco);
+  #else
+    // Report the offset right away, once a block planned with a new offset starts executing.
+    static uint8_t report_wco_generation;
+    uint8_t wco_generation = system_get_wco(wco);
+    if (wco_generation != report_wco_generation) {
+      report_wco_generation = wco_generation;
+      sys.report_wco_counter = 0;
     }
+  #endif
+  if (bit_isfalse(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE)) {
+    for (idx=0; idx< N_AXIS; idx++) { print_position[idx] -= wco[idx]; }
   }
 
   // Report machine position
@@ -520,6 +665,10 @@ void report_realtime_status()
       print_uint8_base10(plan_get_block_buffer_available());
       serial_write(',');
       print_uint32_base10(serial_get_rx_buffer_available());
+      #ifdef REPORT_FIELD_QUEUED_TIME
+        printPgmString(PSTR("|Qt:"));
+        print_uint32_base10(st_get_queued_time()*60000.0);
+      #endif
     }
   #endif
 
@@ -543,7 +692,7 @@ void report_realtime_status()
       printPgmString(PSTR("|FS:"));
       printFloat_RateValue(st_get_realtime_rate());
       serial_write(',');
-      printFloat(sys.spindle_speed,N_DECIMAL_RPMVALUE);
+      printFloat(spindle_get_speed(sys.spindle_level),N_DECIMAL_RPMVALUE);
     #else
       printPgmString(PSTR("|F:"));
       printFloat_RateValue(st_get_realtime_rate());
@@ -576,6 +725,11 @@ void report_realtime_status()
     }
   #endif
 
+  #ifdef REPORT_FIELD_UNDERRUNS
+    printPgmString(PSTR("|Un:"));
+    report_util_underrun_values();
+  #endif
+
   #ifdef REPORT_FIELD_WORK_COORD_OFFSET
     if (sys.report_wco_counter > 0) { sys.report_wco_counter--; }
     else {
@@ -38,6 +38,9 @@
 #define STATUS_LINE_LENGTH_EXCEEDED 14
 #define STATUS_TRAVEL_EXCEEDED 15
 #define STATUS_INVALID_JOG_COMMAND 16
+#define STATUS_PROGRAM_INVALID 17
+#define STATUS_PROGRAM_STORAGE_FULL 18
+#define STATUS_PROGRAM_FLASH_FAIL 19
 
 #define STATUS_GCODE_UNSUPPORTED_COMMAND 20
 #define STATUS_GCODE_MODAL_GROUP_VIOLATION 21
@@ -58,6 +61,8 @@
 #define STATUS_GCODE_UNUSED_WORDS 36
 #define STATUS_GCODE_G43_DYNAMIC_AXIS_ERROR 37
 #define STATUS_GCODE_MAX_VALUE_EXCEEDED 38
+#define STATUS_GCODE_INVALID_CANNED_CYCLE 39
+#define STATUS_HEIGHT_MAP_PROBE_FAIL 40
 
 // Define Grbl alarm codes. Valid values (1-255). 0 is reserved.
 #define ALARM_HARD_LIMIT_ERROR      EXEC_ALARM_HARD_LIMIT
@@ -123,6 +128,28 @@ void report_execute_startup_message(char *line, uint8_t status_code);
 // Prints build info and user info
 void report_build_info(char *line);
 
+// Prints stored program info and the line a stored program stopped at with an error
+void report_program_info();
+void report_program_line(uint32_t n, char *line);
+
+#ifdef HEIGHT_MAP
+  // Prints the height map grid and heights
+  void report_heightmap();
+#endif
+
+#ifdef GC_LINE_CACHE_SIZE
+  // Prints g-code parser line cache hit and miss counters
+  void report_line_cache_counters();
+#endif
+
+// Prints the segment buffer underrun and planner starvation counters
+void report_underruns();
+
+#ifdef CPU_PROFILE
+  // Prints the cycle counting profiler statistics
+  void report_profile();
+#endif
+
 #ifdef DEBUG
   void report_realtime_debug();
 #endif
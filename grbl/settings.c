@@ -46,10 +46,15 @@ void settings_store_build_info(char *line)
 }
 
 
+#ifdef DEFER_COORD_DATA_COMMIT
+  static bool settings_commit_pending; // Coordinate data written but not yet committed to flash.
+#endif
+
+
 // Method to store coord data parameters into EEPROM
 void settings_write_coord_data(uint8_t coord_select, float *coord_data, bool force, bool commit)
 {
-  #ifdef FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE
+  #if defined(FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE) && !defined(DEFER_COORD_DATA_COMMIT)
     protocol_buffer_synchronize();
   #endif
   #ifdef STORE_COORD_DATA
@@ -58,12 +63,30 @@ void settings_write_coord_data(uint8_t coord_select, float *coord_data, bool for
   if(force) {
     uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
     memcpy_to_eeprom_with_checksum(addr,(char*)coord_data, sizeof(float)*N_AXIS);
-    if(commit)
-      eeprom_commit();
+    if(commit) {
+      #ifdef DEFER_COORD_DATA_COMMIT
+        settings_commit_pending = true; // Committed by settings_commit_deferred(), once motion is done.
+      #else
+        eeprom_commit();
+      #endif
+    }
   }
 }
 
 
+// Commits deferred coordinate data to flash. Only called when no motion is executing, as a flash
+// write holds off all interrupts.
+void settings_commit_deferred()
+{
+  #ifdef DEFER_COORD_DATA_COMMIT
+    if (settings_commit_pending) {
+      settings_commit_pending = false;
+      eeprom_commit();
+    }
+  #endif
+}
+
+
 // Method to store Grbl global settings struct and version number into EEPROM
 // NOTE: This function can only be called in IDLE state.
 void write_global_settings(bool commit)
@@ -96,6 +119,12 @@ void settings_restore(uint8_t restore_flag) {
     settings.homing_debounce_delay = DEFAULT_HOMING_DEBOUNCE_DELAY;
     settings.homing_pulloff = DEFAULT_HOMING_PULLOFF;
 
+    settings.slowdown_buffer_time = DEFAULT_SLOWDOWN_BUFFER_TIME;
+    settings.slowdown_min_rate = DEFAULT_SLOWDOWN_MIN_RATE;
+
+    settings.probe_latch_rate = DEFAULT_PROBE_LATCH_RATE;
+    settings.probe_retract = DEFAULT_PROBE_RETRACT;
+
     settings.flags = 0;
     if (DEFAULT_REPORT_INCHES)     { settings.flags |= BITFLAG_REPORT_INCHES;     }
     if (DEFAULT_LASER_MODE)        { settings.flags |= BITFLAG_LASER_MODE;        }
@@ -105,18 +134,24 @@ void settings_restore(uint8_t restore_flag) {
 
     settings.acceleration[X_AXIS] = DEFAULT_X_ACCELERATION;
     settings.current[X_AXIS] = DEFAULT_X_CURRENT;
+    settings.axis_homing_seek_rate[X_AXIS] = DEFAULT_X_HOMING_SEEK_RATE;
+    settings.axis_homing_feed_rate[X_AXIS] = DEFAULT_X_HOMING_FEED_RATE;
     settings.max_rate[X_AXIS] = DEFAULT_X_MAX_RATE;
     settings.max_travel[X_AXIS] = (-DEFAULT_X_MAX_TRAVEL);
     settings.steps_per_mm[X_AXIS] = DEFAULT_X_STEPS_PER_MM;
 
     settings.acceleration[Y_AXIS] = DEFAULT_Y_ACCELERATION;
     settings.current[Y_AXIS] = DEFAULT_Y_CURRENT;
+    settings.axis_homing_seek_rate[Y_AXIS] = DEFAULT_Y_HOMING_SEEK_RATE;
+    settings.axis_homing_feed_rate[Y_AXIS] = DEFAULT_Y_HOMING_FEED_RATE;
     settings.max_rate[Y_AXIS] = DEFAULT_Y_MAX_RATE;
     settings.max_travel[Y_AXIS] = (-DEFAULT_Y_MAX_TRAVEL);
     settings.steps_per_mm[Y_AXIS] = DEFAULT_Y_STEPS_PER_MM;
 
     settings.acceleration[Z_AXIS] = DEFAULT_Z_ACCELERATION;
     settings.current[Z_AXIS] = DEFAULT_Z_CURRENT;
+    settings.axis_homing_seek_rate[Z_AXIS] = DEFAULT_Z_HOMING_SEEK_RATE;
+    settings.axis_homing_feed_rate[Z_AXIS] = DEFAULT_Z_HOMING_FEED_RATE;
     settings.max_rate[Z_AXIS] = DEFAULT_Z_MAX_RATE;
     settings.max_travel[Z_AXIS] = (-DEFAULT_Z_MAX_TRAVEL);
     settings.steps_per_mm[Z_AXIS] = DEFAULT_Z_STEPS_PER_MM;
@@ -124,6 +159,8 @@ void settings_restore(uint8_t restore_flag) {
 #if (N_ARGS > 3)
     settings.acceleration[A_AXIS] = DEFAULT_A_ACCELERATION;
     settings.current[A_AXIS] = DEFAULT_A_CURRENT;
+    settings.axis_homing_seek_rate[A_AXIS] = DEFAULT_A_HOMING_SEEK_RATE;
+    settings.axis_homing_feed_rate[A_AXIS] = DEFAULT_A_HOMING_FEED_RATE;
     settings.max_rate[A_AXIS] = DEFAULT_A_MAX_RATE;
     settings.max_travel[A_AXIS] = (-DEFAULT_A_MAX_TRAVEL);
     settings.steps_per_mm[A_AXIS] = DEFAULT_A_STEPS_PER_MM;
@@ -132,6 +169,8 @@ void settings_restore(uint8_t restore_flag) {
 #if (N_ARGS > 4)
     settings.acceleration[B_AXIS] = DEFAULT_B_ACCELERATION;
     settings.current[B_AXIS] = DEFAULT_B_CURRENT;
+    settings.axis_homing_seek_rate[B_AXIS] = DEFAULT_B_HOMING_SEEK_RATE;
+    settings.axis_homing_feed_rate[B_AXIS] = DEFAULT_B_HOMING_FEED_RATE;
     settings.max_rate[B_AXIS] = DEFAULT_B_MAX_RATE;
     settings.max_travel[B_AXIS] = (-DEFAULT_B_MAX_TRAVEL);
     settings.steps_per_mm[B_AXIS] = DEFAULT_B_STEPS_PER_MM;
@@ -252,8 +291,10 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
           case 3: settings.max_travel[parameter] = -value; break;  // Store as negative for grbl internal use.
           case 4:
             settings.current[parameter] = value;
-            set_current(parameter, settings.current[parameter]);
+            set_axis_current(parameter, settings.current[parameter]);
             break;
+          case 5: settings.axis_homing_seek_rate[parameter] = value; break;
+          case 6: settings.axis_homing_feed_rate[parameter] = value; break;
         }
         break; // Exit while-loop after setting has been configured and proceed to the EEPROM write call.
       } else {
@@ -316,6 +357,12 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
       case 34: settings.spindle_pwm_off_value = value; spindle_init(); break; // Re-initialize spindle pwm calibration
       case 35: settings.spindle_pwm_min_value = value; spindle_init(); break; // Re-initialize spindle pwm calibration
       case 36: settings.spindle_pwm_max_value = value; spindle_init(); break; // Re-initialize spindle pwm calibration
+      case 40: settings.slowdown_buffer_time = value; break;
+      case 41:
+        if ((int_value == 0) || (value > 100.0)) { return(STATUS_INVALID_STATEMENT); }
+        settings.slowdown_min_rate = int_value; break;
+      case 42: settings.probe_latch_rate = value; break;
+      case 43: settings.probe_retract = value; break;
       default:
         return(STATUS_INVALID_STATEMENT);
     }
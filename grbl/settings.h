@@ -27,7 +27,7 @@
 
 // Version of the EEPROM data. Will be used to migrate existing data from older versions of Grbl
 // when firmware is upgraded. Always stored in byte 0 of EEPROM.
-#define SETTINGS_VERSION 12  // NOTE: Check settings_reset() when moving to next version.
+#define SETTINGS_VERSION 15  // NOTE: Check settings_reset() when moving to next version.
 
 // Define bit flag masks for the boolean settings in settings.flag.
 #define BITFLAG_REPORT_INCHES      bit(0)
@@ -68,7 +68,7 @@
 // #define SETTING_INDEX_G92    N_COORDINATE_SYSTEM+2  // Coordinate offset (G92.2,G92.3 not supported)
 
 // Define Grbl axis settings numbering scheme. Starts at START_VAL, every INCREMENT, over N_SETTINGS.
-#define AXIS_N_SETTINGS          5
+#define AXIS_N_SETTINGS          7
 #define AXIS_SETTINGS_START_VAL  100 // NOTE: Reserving settings values >= 100 for axis settings. Up to 255.
 #define AXIS_SETTINGS_INCREMENT  10  // Must be greater than the number of axis settings
 
@@ -80,6 +80,8 @@ typedef struct {
   float acceleration[N_AXIS];
   float max_travel[N_AXIS];  // NOTE: Stored as a negative value
   float current[N_AXIS];
+  float axis_homing_seek_rate[N_AXIS]; // 0 uses homing_seek_rate.
+  float axis_homing_feed_rate[N_AXIS]; // 0 uses homing_feed_rate.
 
   // Remaining Grbl settings
   uint8_t pulse_microseconds;
@@ -102,6 +104,12 @@ typedef struct {
   float homing_seek_rate;
   uint16_t homing_debounce_delay;
   float homing_pulloff;
+
+  float slowdown_buffer_time; // Queued motion time below which new blocks are slowed down (ms). 0 disables.
+  uint8_t slowdown_min_rate;  // Lowest speed new blocks are slowed down to, in percent of their nominal speed.
+
+  float probe_latch_rate;     // Slow probing rate after the seek and retract of two-stage probing (mm/min). 0 disables.
+  float probe_retract;        // Retract distance from the seek trigger point of two-stage probing (mm).
 } settings_t;
 extern settings_t settings;
 
@@ -129,6 +137,9 @@ uint8_t settings_read_build_info(char *line);
 // Writes selected coordinate data to EEPROM
 void settings_write_coord_data(uint8_t coord_select, float *coord_data, bool force, bool commit);
 
+// Commits coordinate data writes deferred until motion is done
+void settings_commit_deferred();
+
 // Reads selected coordinate data from EEPROM
 uint8_t settings_read_coord_data(uint8_t coord_select, float *coord_data);
 
@@ -29,9 +29,22 @@ using namespace board;
 static float pwm_gradient;  // Precalculated value to speed up rpm to PWM conversions.
 float spindle_pwm_period;
 float spindle_pwm_off_value;
+uint32_t spindle_pwm_off_width;
 float spindle_pwm_min_value;
 float spindle_pwm_max_value;
+uint32_t spindle_pwm_lut[SPINDLE_PWM_LEVELS+1];
+static float spindle_levels_per_rpm;
+#ifdef SPINDLE_PWM_CURVE
+static const float spindle_pwm_curve[] = SPINDLE_PWM_CURVE;
+#define SPINDLE_PWM_CURVE_POINTS (sizeof(spindle_pwm_curve)/sizeof(float))
 #endif
+#endif
+
+// RAM copies of the spindle pins for spindle_set_outputs(), which the stepper ISR calls. The constexpr
+// originals are in flash, which can't be read while it's written.
+static GPIO::Detail::Bus spindle_enable_port = GPIO::Detail::to_bus(spindle::enable);
+static GPIO::Detail::Bus spindle_direction_port = GPIO::Detail::to_bus(spindle::direction);
+static GPIO::Detail::Bus spindle_led_port = GPIO::Detail::to_bus(leds[2]);
 
 void
 spindle_init() {
@@ -41,6 +54,7 @@ spindle_init() {
 #ifdef VARIABLE_SPINDLE
     spindle_pwm_period = (SystemCoreClock / settings.spindle_pwm_freq);
     spindle_pwm_off_value = (spindle_pwm_period * settings.spindle_pwm_off_value / 100);
+    spindle_pwm_off_width = spindle_pwm_off_value;
     spindle_pwm_min_value = (spindle_pwm_period * settings.spindle_pwm_min_value / 100);
     spindle_pwm_max_value = (spindle_pwm_period * settings.spindle_pwm_max_value / 100);
     pwm_init(&SPINDLE_PWM_CHANNEL, SPINDLE_PWM_USE_PRIMARY_PIN, SPINDLE_PWM_USE_SECONDARY_PIN,
@@ -49,6 +63,8 @@ spindle_init() {
 
     pwm_gradient =
         (spindle_pwm_max_value - spindle_pwm_min_value) / (settings.rpm_max - settings.rpm_min);
+    spindle_levels_per_rpm = SPINDLE_PWM_LEVELS / settings.rpm_max;
+    spindle_update_pwm_lut();
 #endif
 
     spindle_stop();
@@ -89,34 +105,83 @@ spindle_stop() {
 
 #ifdef VARIABLE_SPINDLE
 // Sets spindle speed PWM output and enable pin, if configured. Called by spindle_set_state()
-// and stepper ISR. Keep routine small and efficient.
-void
+// and stepper ISR. Keep routine small and efficient. Kept in RAM for the stepper ISR.
+FASTCODE void
 spindle_set_speed(uint32_t pwm_value) {
     pwm_set_width(&SPINDLE_PWM_CHANNEL, pwm_value);
 }
 
-// Called by spindle_set_state() and step segment generator. Keep routine small and efficient.
-uint32_t
-spindle_compute_pwm_value(float rpm) {
+// Computes the PWM register value for the given RPM, after overrides. Used to build the PWM lookup
+// table, so it isn't time critical.
+static uint32_t
+spindle_rpm_to_pwm(float rpm) {
     uint32_t pwm_value;
-    rpm *= (0.010 * sys.spindle_speed_ovr);  // Scale by spindle speed override value.
     if (rpm <= 0) {
-        sys.spindle_speed = 0;
         pwm_value = spindle_pwm_off_value;
     } else if (rpm <= settings.rpm_min) {
-        sys.spindle_speed = settings.rpm_min;
         pwm_value = spindle_pwm_min_value;
     } else if (rpm >= settings.rpm_max) {
-        sys.spindle_speed = settings.rpm_max;
         pwm_value = spindle_pwm_max_value - 1;
     } else {
-        sys.spindle_speed = rpm;
+#ifdef SPINDLE_PWM_CURVE
+        // Interpolate the calibration curve point pair around the rpm.
+        float point = (rpm - settings.rpm_min) * (SPINDLE_PWM_CURVE_POINTS - 1) /
+                      (settings.rpm_max - settings.rpm_min);
+        uint8_t idx = point;
+        float percent = spindle_pwm_curve[idx] +
+                        (point - idx) * (spindle_pwm_curve[idx + 1] - spindle_pwm_curve[idx]);
+        pwm_value = floor(0.01 * percent * (spindle_pwm_max_value - spindle_pwm_min_value)) +
+                    spindle_pwm_min_value;
+#else
         pwm_value = floor((rpm - settings.rpm_min) * pwm_gradient) + spindle_pwm_min_value;
+#endif
         if (pwm_value >= spindle_pwm_max_value)
             pwm_value = spindle_pwm_max_value - 1;
     }
     return (pwm_value);
 }
+
+// Rebuilds the PWM lookup table for the current spindle settings and speed override. Called by
+// spindle_init() and upon spindle speed override changes.
+void
+spindle_update_pwm_lut() {
+    float rpm_per_level = (0.010 * sys.spindle_speed_ovr) / spindle_levels_per_rpm;
+    for (uint32_t level = 0; level <= SPINDLE_PWM_LEVELS; level++) {
+        spindle_pwm_lut[level] = spindle_rpm_to_pwm(level * rpm_per_level);
+    }
+}
+
+// Quantizes the programmed RPM to a PWM lookup table level. Any RPM above zero is at least the
+// first level, which keeps the spindle on. Called by the step segment generator once per block.
+uint16_t
+spindle_get_level(float rpm) {
+    if (rpm <= 0) {
+        return (0);
+    }
+    float level = rpm * spindle_levels_per_rpm + 0.5;
+    if (level >= SPINDLE_PWM_LEVELS) {
+        return (SPINDLE_PWM_LEVELS);
+    }
+    return (std::max((uint16_t)level, (uint16_t)1));
+}
+
+// Returns the spindle speed of the level, after overrides, as set by spindle_compute_pwm_value().
+// Called by status reports only, so the step segment generator doesn't compute it.
+float
+spindle_get_speed(uint16_t level) {
+    if (level == 0) {
+        return (0.0);
+    }
+    float rpm = level * (0.010 * sys.spindle_speed_ovr) / spindle_levels_per_rpm;
+    return (std::min(std::max(rpm, settings.rpm_min), settings.rpm_max));
+}
+
+// Called by spindle_set_state() and step segment generator. Keep routine small and efficient.
+uint32_t
+spindle_compute_pwm_value(float rpm) {
+    sys.spindle_level = spindle_get_level(rpm);
+    return (spindle_pwm_lut[sys.spindle_level]);
+}
 #endif
 
 // Immediately sets spindle running state with direction and spindle rpm via PWM, if enabled.
@@ -138,7 +203,7 @@ _spindle_set_state(uint8_t state)
     if (state == SPINDLE_STATE_DISABLE) {
         spindle_stop();
 #ifdef VARIABLE_SPINDLE
-        sys.spindle_speed = 0.0;
+        sys.spindle_level = 0;
 #endif
     } else {
 #ifdef VARIABLE_SPINDLE
@@ -164,6 +229,20 @@ _spindle_set_state(uint8_t state)
     sys.report_ovr_counter = 0;
 }
 
+// Sets the spindle enable and direction pins of the state, leaving the PWM output to the caller.
+// Called by the stepper ISR for queued spindle commands. Kept in RAM for the stepper ISR.
+FASTCODE void
+spindle_set_outputs(uint8_t state) {
+    if (state == SPINDLE_DISABLE) {
+        spindle_enable_port.write(0);
+        spindle_led_port.write(0);
+    } else {
+        spindle_direction_port.write((state == SPINDLE_ENABLE_CCW) ? spindle_direction_port.mask : 0);
+        spindle_enable_port.write(spindle_enable_port.mask);
+        spindle_led_port.write(spindle_led_port.mask);
+    }
+}
+
 // G-code parser entry-point for setting spindle state. Forces a planner buffer sync and bails
 // if an abort or check-mode is active.
 #ifdef VARIABLE_SPINDLE
@@ -42,8 +42,10 @@ uint8_t spindle_get_state();
 #ifdef VARIABLE_SPINDLE
   extern float spindle_pwm_period;
   extern float spindle_pwm_off_value;
+  extern uint32_t spindle_pwm_off_width; // spindle_pwm_off_value as a PWM width. No float math in ISRs.
   extern float spindle_pwm_min_value;
   extern float spindle_pwm_max_value;
+  extern uint32_t spindle_pwm_lut[SPINDLE_PWM_LEVELS+1]; // PWM values indexed by spindle speed level.
 
   // Called by g-code parser when setting spindle state and requires a buffer sync.
   void spindle_sync(uint8_t state, float rpm);
@@ -56,6 +58,15 @@ uint8_t spindle_get_state();
   
   // Computes PWM register value for the given RPM for quick updating.
   uint32_t spindle_compute_pwm_value(float rpm);
+
+  // Rebuilds the PWM lookup table. Called when the spindle speed override changes.
+  void spindle_update_pwm_lut();
+
+  // Quantizes a programmed RPM to a PWM lookup table level.
+  uint16_t spindle_get_level(float rpm);
+
+  // Returns the spindle speed of a PWM lookup table level, after overrides. Used for reporting.
+  float spindle_get_speed(uint16_t level);
   
 #else
   
@@ -72,4 +83,8 @@ uint8_t spindle_get_state();
 // Stop and start spindle routines. Called by all spindle routines and stepper ISR.
 void spindle_stop();
 
+// Sets the spindle enable and direction pins quickly for the stepper ISR, which applies queued
+// spindle commands. The stepper ISR sets the spindle PWM separately.
+void spindle_set_outputs(uint8_t state);
+
 #endif
@@ -36,6 +36,9 @@ using namespace board;
 #define PREP_FLAG_PARKING            bit(2)
 #define PREP_FLAG_DECEL_OVERRIDE     bit(3)
 
+// Fractional bits of the laser power ramp, which the stepper ISR steps the spindle PWM by.
+#define SPINDLE_PWM_RAMP_SHIFT 8
+
 // Define Adaptive Multi-Axis Step-Smoothing(AMASS) levels and cutoff frequencies. The highest level
 // frequency bin starts at 0Hz and ends at its cutoff frequency. The next lower level frequency bin
 // starts at the next higher cutoff frequency, and so on. The cutoff frequencies for each level must
@@ -68,9 +71,20 @@ typedef struct {
   uint32_t steps[N_AXIS];
   uint32_t step_event_count;
   uint32_t direction_bits;
+  uint8_t event;            // Event flags of event blocks, which apply the accessory state when started.
+  uint8_t accessory_state;  // Spindle and coolant state of an event block. (PL_COND flags)
   #ifdef VARIABLE_SPINDLE
     uint8_t is_pwm_rate_adjusted; // Tracks motions that require constant laser power/rate
   #endif
+  #ifdef LASER_RASTER
+    // Raster scanline data. The pixel power switches as the scanline axis steps across pixel boundaries.
+    const uint8_t *raster_pixels; // Pixel powers of a scanline block. NULL, if not a scanline.
+    uint16_t raster_count;        // Number of pixels.
+    uint16_t raster_level;        // Spindle PWM level of full pixel power.
+    uint32_t raster_rate;         // Pixels per step, in 1/65536 pixels.
+    uint32_t raster_steps;        // Steps of the scanline, after which its buffer is released.
+    uint32_t raster_step_mask;    // Step bit of the scanline axis.
+  #endif
 } st_block_t;
 static st_block_t st_block_buffer[SEGMENT_BUFFER_SIZE-1];
 
@@ -88,7 +102,8 @@ typedef struct {
     uint8_t prescaler;      // Without AMASS, a prescaler is required to adjust for slow timing.
   #endif
   #ifdef VARIABLE_SPINDLE
-    uint32_t spindle_pwm;
+    uint32_t spindle_pwm;       // Spindle PWM output at the segment start.
+    int32_t spindle_pwm_delta;  // Laser power ramp per ISR tick, in 1/2^SPINDLE_PWM_RAMP_SHIFT PWM units.
   #endif
 } segment_t;
 static segment_t segment_buffer[SEGMENT_BUFFER_SIZE];
@@ -110,6 +125,18 @@ typedef struct {
     uint32_t steps[N_AXIS];
   #endif
 
+  #ifdef VARIABLE_SPINDLE
+    uint32_t spindle_pwm;       // Laser power ramp output, in 1/2^SPINDLE_PWM_RAMP_SHIFT PWM units.
+    int32_t spindle_pwm_delta;
+  #endif
+
+  #ifdef LASER_RASTER
+    uint32_t raster_position; // Scanline position, in 1/65536 pixels.
+    uint32_t raster_steps;    // Scanline steps remaining.
+    uint16_t raster_pixel;    // Pixel being burnt.
+    uint32_t raster_pwm;      // Spindle PWM output of the pixel.
+  #endif
+
   uint16_t step_count;       // Steps remaining in line segment motion
   uint8_t exec_block_index; // Tracks the current st_block index. Change indicates new block.
   st_block_t *exec_block;   // Pointer to the block data for the segment being executed
@@ -117,6 +144,21 @@ typedef struct {
 } stepper_t;
 static stepper_t st;
 
+// Motion time in the segment buffer, in timer ticks. The prep adds the time of each prepped segment
+// and the stepper ISR the time of each completed one, so their difference is the time left. Each is
+// written by one side only, so no locking is needed, and the difference is safe across wrapping.
+static uint32_t segment_buffer_ticks_prepped;
+static volatile uint32_t segment_buffer_ticks_executed;
+
+// Starvation counters. The minimum buffered time is kept in timer ticks until reported.
+static volatile uint32_t st_segment_underruns;
+static uint32_t st_planner_starved;
+static uint32_t st_min_buffered_ticks;
+
+// Bresenham state of the segment being executed, as the probe triggered. Locates the trigger between
+// steps. Recorded by the stepper ISR and converted into a step fraction only when reported.
+static probe_steps_t st_probe;
+
 // Step segment ring buffer indices
 static volatile uint8_t segment_buffer_tail;
 static uint8_t segment_buffer_head;
@@ -125,6 +167,14 @@ static uint8_t segment_next_head;
 // Used to avoid ISR nesting of the "Stepper Driver Interrupt". Should never occur though.
 static volatile uint8_t busy;
 
+// RAM copies of the stepper pin definitions used by the stepper ISR. The constexpr originals are
+// in flash, which can't be read while it's written. Masks are set by stepper_init().
+static GPIO::Detail::Bus st_step_port = step::step;
+static GPIO::Detail::Bus st_direction_port = step::direction;
+static GPIO::Detail::Bus st_enable_port = step::enable;
+static uint32_t st_step_mask[N_AXIS];
+static uint32_t st_direction_mask[N_AXIS];
+
 // Pointers for the step segment being prepped from the planner buffer. Accessed only by the
 // main program. Pointers may be planning segments or planner blocks ahead of what being executed.
 static plan_block_t *pl_block;     // Pointer to the planner block being prepped
@@ -158,7 +208,8 @@ typedef struct {
   float decelerate_after; // Deceleration ramp start measured from end of block (mm)
 
   #ifdef VARIABLE_SPINDLE
-    float inv_rate;    // Used by PWM laser mode to speed up segment calculations.
+    uint16_t spindle_level;   // PWM lookup table level of the block spindle speed.
+    float spindle_level_rate; // Level per unit speed. Used by PWM laser mode to speed up segment calculations.
     uint32_t current_spindle_pwm;
   #endif
 } st_prep_t;
@@ -231,8 +282,8 @@ void st_wake_up()
   LPC_TIM1->TCR = 0b01;   // enable Timer Control (0b10=Reset, 0b01=Enable)
 }
 
-// Stepper shutdown
-void st_go_idle()
+// Stepper shutdown. Also called by the stepper ISR, so it's kept in RAM.
+FASTCODE void st_go_idle()
 {
   // Disable Stepper Driver Interrupt. Allow Stepper Port Reset Interrupt to finish, if active.
   LPC_TIM1->TCR = 0;          // Disable Timer1 Control (0b10=Reset, 0b01=Enable)
@@ -242,10 +293,11 @@ void st_go_idle()
   if (((settings.stepper_idle_lock_time != 0xff) || sys_rt_exec_alarm || sys.state == STATE_SLEEP) && sys.state != STATE_HOMING) {
     // Force stepper dwell to lock axes for a defined amount of time to ensure the axes come to a complete
     // stop and not drift from residual inertial forces at the end of the last movement.
-    delay_ms(settings.stepper_idle_lock_time);
+    // NOTE: 32-bit math. 64-bit division is a library call in flash.
+    delay_loop(get_time(), settings.stepper_idle_lock_time * (SystemCoreClock / 1000));
 
     // Disable step drivers
-    step::enable.write(0);
+    st_enable_port.write(0);
   }
 }
 
@@ -298,13 +350,15 @@ void st_go_idle()
 // TODO: Replace direct updating of the int32 position counters in the ISR somehow. Perhaps use smaller
 // int8 variables and update position counters only when a segment completes. This can get complicated
 // with probing and homing cycles that require true real-time positions.
-extern "C" void TIMER1_IRQHandler()
+// NOTE: Runs from RAM, so stepping continues while flash is written. See iap_command().
+extern "C" FASTCODE void TIMER1_IRQHandler()
 {
+  PROFILE(PROFILE_STEPPER_ISR);
   LPC_TIM1->IR = LPC_TIM1->IR; // Clear interrupt
   if (busy) { return; } // The busy-flag is used to avoid reentering this interrupt
 
   // Set the direction pins a couple of nanoseconds before we step the steppers
-  step::direction.write(st.dir_outbits);
+  st_direction_port.write(st.dir_outbits);
 
   // Then pulse the stepping pins
   #ifdef STEP_PULSE_DELAY
@@ -312,7 +366,7 @@ extern "C" void TIMER1_IRQHandler()
     st.step_bits = (STEP_PORT & ~STEP_MASK) | st.step_outbits; // Store out_bits to prevent overwriting.
   #else  // Normal operation
     delay_loop(get_time(), st.step_setup_time);
-    step::step.write(st.step_outbits);
+    st_step_port.write(st.step_outbits);
     // Mark time step bits were set
     uint32_t step_start_time = get_time();
   #endif
@@ -353,9 +407,31 @@ extern "C" void TIMER1_IRQHandler()
 
         // Initialize Bresenham line and distance counters
         st.counter[X_AXIS] = st.counter[Y_AXIS] = st.counter[Z_AXIS] = (st.exec_block->step_event_count >> 1);
+
+        // Apply the spindle and coolant state of an event block at its exact place in the path.
+        if (st.exec_block->event) {
+          if (st.exec_block->event & PL_EVENT_SPINDLE) {
+            spindle_set_outputs(st.exec_block->accessory_state & (PL_COND_FLAG_SPINDLE_CW|PL_COND_FLAG_SPINDLE_CCW));
+          }
+          if (st.exec_block->event & PL_EVENT_COOLANT) {
+            coolant_set_outputs(st.exec_block->accessory_state & (PL_COND_FLAG_COOLANT_FLOOD|PL_COND_FLAG_COOLANT_MIST));
+          }
+          sys.report_ovr_counter = 0; // Set to report change immediately
+        }
       }
       st.dir_outbits = st.exec_block->direction_bits;
 
+      #ifdef LASER_RASTER
+        // Start a new scanline at its first pixel. A scanline resumed after a feed hold keeps its
+        // st_block and continues from where it stopped.
+        if (st.exec_block->raster_pixels && (st.raster_steps == 0)) {
+          st.raster_position = 0;
+          st.raster_steps = st.exec_block->raster_steps;
+          st.raster_pixel = 0;
+          st.raster_pwm = spindle_pwm_lut[(st.exec_block->raster_level*st.exec_block->raster_pixels[0])/255];
+        }
+      #endif
+
       #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
         // With AMASS enabled, adjust Bresenham axis increment counters according to AMASS level.
         st.steps[X_AXIS] = st.exec_block->steps[X_AXIS] >> st.exec_segment->amass_level;
@@ -371,19 +447,35 @@ extern "C" void TIMER1_IRQHandler()
 
       #ifdef VARIABLE_SPINDLE
         // Set real-time spindle output as segment is loaded, just prior to the first step.
+        #ifdef LASER_RASTER
+          if (st.exec_block->raster_pixels) { spindle_set_speed(st.raster_pwm); }
+          else
+        #endif
         spindle_set_speed(st.exec_segment->spindle_pwm);
+        st.spindle_pwm = st.exec_segment->spindle_pwm << SPINDLE_PWM_RAMP_SHIFT;
+        st.spindle_pwm_delta = st.exec_segment->spindle_pwm_delta;
       #endif
 
     } else {
       // Reset stepping pins after delay
       delay_loop(step_start_time, st.step_pulse_time);
-      step::step.write(0);
+      st_step_port.write(0);
 
-      // Segment buffer empty. Shutdown.
+      // Segment buffer empty. Count an underrun, if the prep fell behind with planned motion left,
+      // rather than the motion ending or being held.
+      if ((sys.state == STATE_CYCLE) && bit_isfalse(sys.step_control,STEP_CONTROL_END_MOTION) &&
+          (plan_get_current_block() != NULL)) { st_segment_underruns++; }
+
+      // Shutdown.
       st_go_idle();
       #ifdef VARIABLE_SPINDLE
         // Ensure pwm is set properly upon completion of rate-controlled motion.
-        if (st.exec_block->is_pwm_rate_adjusted) { spindle_set_speed(spindle_pwm_off_value); }
+        if (st.exec_block->is_pwm_rate_adjusted) { spindle_set_speed(spindle_pwm_off_width); }
+      #endif
+      #ifdef LASER_RASTER
+        // A scanline stopped by a feed hold or an underrun must not burn at rest. The pixel power is
+        // restored by the next segment load of the scanline.
+        if (st.exec_block->raster_pixels) { spindle_set_speed(spindle_pwm_off_width); }
       #endif
       system_set_exec_state_flag(EXEC_CYCLE_STOP); // Flag main program for cycle end
       return; // Nothing to do but exit.
@@ -392,7 +484,23 @@ extern "C" void TIMER1_IRQHandler()
 
 
   // Check probing state.
-  if (sys_probe_state == PROBE_ACTIVE) { probe_state_monitor(); }
+  if (sys_probe_state == PROBE_ACTIVE) {
+    probe_state_monitor();
+    if (sys_probe_state == PROBE_OFF) {
+      uint8_t idx;
+      st_probe.direction_bits = 0;
+      for (idx=0; idx<N_AXIS; idx++) {
+        st_probe.counter[idx] = st.counter[idx];
+        #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+          st_probe.steps[idx] = st.steps[idx];
+        #else
+          st_probe.steps[idx] = st.exec_block->steps[idx];
+        #endif
+        if (st.exec_block->direction_bits & st_direction_mask[idx]) { st_probe.direction_bits |= bit(idx); }
+      }
+      st_probe.step_event_count = st.exec_block->step_event_count;
+    }
+  }
 
   // Reset step out bits.
   st.step_outbits = 0;
@@ -405,9 +513,9 @@ extern "C" void TIMER1_IRQHandler()
       st.counter[axis] += st.exec_block->steps[axis];
     #endif
     if (st.counter[axis] > st.exec_block->step_event_count) {
-      st.step_outbits |= step::step.pins[axis].mask;
+      st.step_outbits |= st_step_mask[axis];
       st.counter[axis] -= st.exec_block->step_event_count;
-      if (st.exec_block->direction_bits & step::direction.pins[axis].mask) { 
+      if (st.exec_block->direction_bits & st_direction_mask[axis]) { 
         sys_position[axis]--;
       } else {
         sys_position[axis]++;
@@ -419,16 +527,45 @@ extern "C" void TIMER1_IRQHandler()
   // During a homing cycle, lock out and prevent desired axes from moving.
   if (sys.state == STATE_HOMING) { st.step_outbits &= sys.homing_axis_lock; }
 
+  #ifdef LASER_RASTER
+    // Switch the scanline pixel power as the scanline axis steps across a pixel boundary.
+    if (st.exec_block->raster_pixels && (st.step_outbits & st.exec_block->raster_step_mask)) {
+      if (--st.raster_steps == 0) {
+        // Last step. The laser is off past the scanline end, and its pixel buffer is freed.
+        st.raster_pwm = spindle_pwm_off_width;
+        spindle_set_speed(st.raster_pwm);
+        raster_release();
+      } else {
+        st.raster_position += st.exec_block->raster_rate;
+        uint16_t pixel = std::min(st.raster_position >> 16, (uint32_t)st.exec_block->raster_count-1);
+        if (pixel != st.raster_pixel) {
+          st.raster_pixel = pixel;
+          st.raster_pwm = spindle_pwm_lut[(st.exec_block->raster_level*st.exec_block->raster_pixels[pixel])/255];
+          spindle_set_speed(st.raster_pwm);
+        }
+      }
+    }
+  #endif
+
+  #ifdef VARIABLE_SPINDLE
+    // Ramp the laser power with the speed through the segment, so it tracks the speed between segments.
+    if (st.spindle_pwm_delta) {
+      st.spindle_pwm += st.spindle_pwm_delta;
+      spindle_set_speed(st.spindle_pwm >> SPINDLE_PWM_RAMP_SHIFT);
+    }
+  #endif
+
   st.step_count--; // Decrement step events count
   if (st.step_count == 0) {
     // Segment is complete. Discard current segment and advance segment indexing.
+    segment_buffer_ticks_executed += st.exec_segment->n_step*st.exec_segment->cycles_per_tick;
     st.exec_segment = NULL;
     if ( ++segment_buffer_tail == SEGMENT_BUFFER_SIZE) { segment_buffer_tail = 0; }
   }
 
   // Reset stepping pins after delay
   delay_loop(step_start_time, st.step_pulse_time);
-  step::step.write(0);
+  st_step_port.write(0);
 
   busy = false;
 }
@@ -480,6 +617,8 @@ void st_reset()
   segment_buffer_tail = 0;
   segment_buffer_head = 0; // empty = tail
   segment_next_head = 1;
+  segment_buffer_ticks_prepped = 0;
+  segment_buffer_ticks_executed = 0;
   busy = false;
 
   st.dir_outbits = 0; // Initialize direction bits to default.
@@ -496,6 +635,10 @@ void stepper_init()
   step::step.init();
   step::direction.init();
   step::enable.init();
+  for (uint8_t idx=0; idx<N_AXIS; idx++) {
+    st_step_mask[idx] = step::step_masks[idx]; // Includes any ganged motors of the axis.
+    st_direction_mask[idx] = step::direction_masks[idx];
+  }
 
   // Configure Timer 1: Stepper Driver Interrupt
   LPC_TIM1->TCR = 0;            // disable Timer Control (0b10=Reset, 0b01=Enable)
@@ -505,6 +648,8 @@ void stepper_init()
   LPC_TIM1->CCR = 0;            // no Capture Control actions
   LPC_TIM1->EMR = 0;            // no External Match (controls external match pins)
   NVIC_EnableIRQ(TIMER1_IRQn);  // Enable Stepper Driver Interrupt
+
+  st_reset_underruns();
 }
 
 
@@ -566,6 +711,80 @@ static uint8_t st_next_block_index(uint8_t block_index)
 #endif
 
 
+// Preps the next segment of an event block, which has no steps. Each event gets a stepper block of its
+// own, so the stepper ISR applies its spindle and coolant state as it starts the first segment. A dwell
+// is prepped as segments of up to DWELL_TIME_STEP ticks of one millisecond each, and an event without
+// a dwell as a single short tick. Returns false, if a feed hold stops the prep at the event.
+FASTCODE static uint8_t st_prep_event(plan_block_t *block)
+{
+  // Hold at the event, once the feed hold brought motion to rest. The event executes upon resuming.
+  if ((sys.step_control & STEP_CONTROL_EXECUTE_HOLD) && (prep.current_speed == 0.0)) {
+    bit_true(sys.step_control,STEP_CONTROL_END_MOTION);
+    return(false);
+  }
+
+  if (pl_block == NULL) {
+    pl_block = block;
+    prep.recalculate_flag &= ~(PREP_FLAG_RECALCULATE); // No velocity profile to recompute.
+
+    // Load a stepper block without steps. It keeps the direction bits of the previous block, so the
+    // direction pins don't change for the event.
+    uint32_t direction_bits = st_block_buffer[prep.st_block_index].direction_bits;
+    prep.st_block_index = st_next_block_index(prep.st_block_index);
+    st_prep_block = &st_block_buffer[prep.st_block_index];
+    memset(st_prep_block->steps,0,sizeof(st_prep_block->steps));
+    st_prep_block->step_event_count = 1;
+    st_prep_block->direction_bits = direction_bits;
+    st_prep_block->event = (pl_block->event & (PL_EVENT_SPINDLE | PL_EVENT_COOLANT));
+    st_prep_block->accessory_state = (pl_block->condition & PL_COND_ACCESSORY_MASK);
+    #ifdef LASER_RASTER
+      st_prep_block->raster_pixels = NULL;
+    #endif
+
+    #ifdef VARIABLE_SPINDLE
+      // Set the spindle PWM of the event, as spindle_set_state() would. Laser mode M4 is off at rest.
+      st_prep_block->is_pwm_rate_adjusted = false;
+      if (pl_block->condition & (PL_COND_FLAG_SPINDLE_CW | PL_COND_FLAG_SPINDLE_CCW)) {
+        float rpm = pl_block->spindle_speed;
+        if ((settings.flags & BITFLAG_LASER_MODE) && (pl_block->condition & PL_COND_FLAG_SPINDLE_CCW)) { rpm = 0.0; }
+        prep.current_spindle_pwm = spindle_compute_pwm_value(rpm);
+      } else {
+        sys.spindle_level = 0;
+        prep.current_spindle_pwm = spindle_pwm_off_value;
+      }
+      bit_true(sys.step_control,STEP_CONTROL_UPDATE_SPINDLE_PWM); // Recompute for the next motion block.
+    #endif
+  }
+
+  segment_t *prep_segment = &segment_buffer[segment_buffer_head];
+  prep_segment->st_block_index = prep.st_block_index;
+  prep_segment->amass_level = 0;
+  #ifdef VARIABLE_SPINDLE
+    prep_segment->spindle_pwm = prep.current_spindle_pwm;
+    prep_segment->spindle_pwm_delta = 0;
+  #endif
+  if (pl_block->dwell) {
+    prep_segment->n_step = std::min(pl_block->dwell, (uint32_t)DWELL_TIME_STEP);
+    prep_segment->cycles_per_tick = SystemCoreClock/1000;
+    pl_block->dwell -= prep_segment->n_step;
+  } else {
+    prep_segment->n_step = 1;
+    prep_segment->cycles_per_tick = SystemCoreClock/100000; // 10 usec
+  }
+
+  // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
+  segment_buffer_ticks_prepped += prep_segment->n_step*prep_segment->cycles_per_tick;
+  segment_buffer_head = segment_next_head;
+  if ( ++segment_next_head == SEGMENT_BUFFER_SIZE ) { segment_next_head = 0; }
+
+  if (pl_block->dwell == 0) { // Event complete. Load the next planner block.
+    pl_block = NULL;
+    plan_discard_current_block();
+  }
+  return(true);
+}
+
+
 /* Prepares step segment buffer. Continuously called from main program.
 
    The segment buffer is an intermediary buffer interface between the execution of steps
@@ -578,14 +797,36 @@ static uint8_t st_next_block_index(uint8_t block_index)
    longer than the time it takes the stepper algorithm to empty it before refilling it.
    Currently, the segment buffer conservatively holds roughly up to 40-50 msec of steps.
    NOTE: Computation units are in steps, millimeters, and minutes.
+   NOTE: Kept in RAM. Runs after every planned or executed segment, so it sets the motion
+   throughput more than any other main program routine.
 */
-void st_prep_buffer()
+FASTCODE void st_prep_buffer()
 {
+  PROFILE(PROFILE_PREP_BUFFER);
   // Block step prep buffer, while in a suspend state and there is no suspend motion to execute.
   if (bit_istrue(sys.step_control,STEP_CONTROL_END_MOTION)) { return; }
 
+  // Track the least motion time left in the running segment buffer, while there is planned motion to
+  // prep. An empty buffer is either the start of the cycle or an underrun, which the ISR counts.
+  if ((sys.state == STATE_CYCLE) && (segment_buffer_tail != segment_buffer_head)) {
+    if ((pl_block != NULL) || (plan_get_current_block() != NULL)) {
+      uint32_t ticks = segment_buffer_ticks_prepped - segment_buffer_ticks_executed;
+      if (ticks < st_min_buffered_ticks) { st_min_buffered_ticks = ticks; }
+    }
+  }
+
   while (segment_buffer_tail != segment_next_head) { // Check if we need to fill the buffer.
 
+    // Event blocks have no motion, only a dwell or a spindle and coolant state to apply. They are
+    // prepped by st_prep_event(), rather than the velocity profile segment generator below.
+    if (bit_isfalse(sys.step_control,STEP_CONTROL_EXECUTE_SYS_MOTION)) {
+      plan_block_t *event_block = (pl_block == NULL) ? plan_get_current_block() : pl_block;
+      if ((event_block != NULL) && (event_block->step_event_count == 0)) {
+        if (!st_prep_event(event_block)) { return; }
+        continue;
+      }
+    }
+
     // Determine if we need to load a new planner block or if the block needs to be recomputed.
     if (pl_block == NULL) {
 
@@ -614,6 +855,7 @@ void st_prep_buffer()
         // segment buffer finishes the prepped block, but the stepper ISR is still executing it.
         st_prep_block = &st_block_buffer[prep.st_block_index];
         st_prep_block->direction_bits = pl_block->direction_bits;
+        st_prep_block->event = 0;
         uint8_t idx;
         #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
           for (idx=0; idx<N_AXIS; idx++) { st_prep_block->steps[idx] = (pl_block->steps[idx] << 1); }
@@ -645,13 +887,32 @@ void st_prep_buffer()
           // Setup laser mode variables. PWM rate adjusted motions will always complete a motion with the
           // spindle off.
           st_prep_block->is_pwm_rate_adjusted = false;
+          prep.spindle_level = spindle_get_level(pl_block->spindle_speed);
           if (settings.flags & BITFLAG_LASER_MODE) {
             if (pl_block->condition & PL_COND_FLAG_SPINDLE_CCW) {
-              // Pre-compute inverse programmed rate to speed up PWM updating per step segment.
-              prep.inv_rate = 1.0/pl_block->programmed_rate;
+              // Pre-compute level per programmed rate to speed up PWM updating per step segment.
+              prep.spindle_level_rate = prep.spindle_level/pl_block->programmed_rate;
               st_prep_block->is_pwm_rate_adjusted = true;
             }
           }
+          #ifdef LASER_RASTER
+            // Scanline pixel powers are set by the stepper ISR at a constant power, rather than by speed.
+            st_prep_block->raster_pixels = NULL;
+            if (pl_block->raster) {
+              st_prep_block->is_pwm_rate_adjusted = false;
+              st_prep_block->raster_pixels = raster_get_pixels(pl_block->raster, &st_prep_block->raster_count);
+              st_prep_block->raster_level = 0;
+              if (pl_block->condition & (PL_COND_FLAG_SPINDLE_CW | PL_COND_FLAG_SPINDLE_CCW)) {
+                st_prep_block->raster_level = prep.spindle_level;
+              }
+              st_prep_block->raster_rate = ((uint32_t)st_prep_block->raster_count << 16)/pl_block->step_event_count;
+              st_prep_block->raster_steps = pl_block->step_event_count;
+              for (idx=0; idx<N_AXIS; idx++) {
+                if (pl_block->steps[idx] == pl_block->step_event_count) { break; }
+              }
+              st_prep_block->raster_step_mask = st_step_mask[idx];
+            }
+          #endif
         #endif
       }
 
@@ -779,6 +1040,9 @@ void st_prep_buffer()
     float mm_remaining = pl_block->millimeters; // New segment distance from end of block.
     float minimum_mm = mm_remaining-prep.req_mm_increment; // Guarantee at least one step.
     if (minimum_mm < 0.0) { minimum_mm = 0.0; }
+    #ifdef VARIABLE_SPINDLE
+      float entry_speed = prep.current_speed; // Segment entry speed for the laser power ramp.
+    #endif
 
     do {
       switch (prep.ramp_type) {
@@ -863,19 +1127,26 @@ void st_prep_buffer()
 
       if (st_prep_block->is_pwm_rate_adjusted || (sys.step_control & STEP_CONTROL_UPDATE_SPINDLE_PWM)) {
         if (pl_block->condition & (PL_COND_FLAG_SPINDLE_CW | PL_COND_FLAG_SPINDLE_CCW)) {
-          float rpm = pl_block->spindle_speed;
+          // NOTE: The lookup table includes the spindle speed override, so only the level is computed here.
+          uint32_t level = prep.spindle_level;
           // NOTE: Feed and rapid overrides are independent of PWM value and do not alter laser power/rate.
-          if (st_prep_block->is_pwm_rate_adjusted) { rpm *= (prep.current_speed * prep.inv_rate); }
-          // If current_speed is zero, then may need to be rpm_min*(100/MAX_SPINDLE_SPEED_OVERRIDE)
-          // but this would be instantaneous only and during a motion. May not matter at all.
-          prep.current_spindle_pwm = spindle_compute_pwm_value(rpm);
+          if (st_prep_block->is_pwm_rate_adjusted) {
+            // Ramp the power from the segment entry speed to the exit speed. Set the entry output here.
+            level = std::min((uint32_t)(entry_speed * prep.spindle_level_rate), (uint32_t)SPINDLE_PWM_LEVELS);
+            prep_segment->spindle_pwm = spindle_pwm_lut[level];
+            level = std::min((uint32_t)(prep.current_speed * prep.spindle_level_rate), (uint32_t)SPINDLE_PWM_LEVELS);
+          }
+          sys.spindle_level = level;
+          prep.current_spindle_pwm = spindle_pwm_lut[level];
         } else {
-          sys.spindle_speed = 0.0;
+          sys.spindle_level = 0;
           prep.current_spindle_pwm = spindle_pwm_off_value;
         }
         bit_false(sys.step_control,STEP_CONTROL_UPDATE_SPINDLE_PWM);
       }
-      prep_segment->spindle_pwm = prep.current_spindle_pwm; // Reload segment PWM value
+      if (!st_prep_block->is_pwm_rate_adjusted) {
+        prep_segment->spindle_pwm = prep.current_spindle_pwm; // Reload segment PWM value
+      }
 
     #endif
 
@@ -952,7 +1223,16 @@ void st_prep_buffer()
       }
     #endif
 
+    #ifdef VARIABLE_SPINDLE
+      // Spread the laser power ramp over the ISR ticks of the segment, ending at the exit output.
+      prep_segment->spindle_pwm_delta = 0;
+      if (st_prep_block->is_pwm_rate_adjusted && prep_segment->n_step) {
+        prep_segment->spindle_pwm_delta = ((int32_t)(prep.current_spindle_pwm - prep_segment->spindle_pwm)*(1 << SPINDLE_PWM_RAMP_SHIFT))/(int32_t)prep_segment->n_step;
+      }
+    #endif
+
     // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
+    segment_buffer_ticks_prepped += prep_segment->n_step*prep_segment->cycles_per_tick;
     segment_buffer_head = segment_next_head;
     if ( ++segment_next_head == SEGMENT_BUFFER_SIZE ) { segment_next_head = 0; }
 
@@ -999,3 +1279,52 @@ float st_get_realtime_rate()
   }
   return 0.0f;
 }
+
+
+// Returns the estimated time of the motion queued for execution in minutes. Sums the segment buffer and
+// the planner buffer, but the executing block is partly in the segment buffer already, so its planned
+// time is swapped for the time of the distance left, from the speed the segment generator reached.
+float st_get_queued_time()
+{
+  float queued_time = plan_get_queued_time();
+  if ((pl_block != NULL) && bit_isfalse(sys.step_control,STEP_CONTROL_EXECUTE_SYS_MOTION)) {
+    queued_time += plan_compute_profile_time(pl_block, prep.current_speed*prep.current_speed,
+                     plan_get_exec_block_exit_speed_sqr()) - pl_block->execution_time;
+  }
+  uint32_t ticks = segment_buffer_ticks_prepped - segment_buffer_ticks_executed;
+  queued_time += ticks/(60.0*SystemCoreClock);
+  if (queued_time < 0.0) { return(0.0); } // Rounding errors of the running sum.
+  return(queued_time);
+}
+
+
+// Called by the planner, when a block is added to an empty planner during a cycle. The machine was
+// still moving with no motion left to plan, so it had to decelerate towards a stop.
+void st_count_planner_starved()
+{
+  st_planner_starved++;
+}
+
+
+void st_get_underruns(st_underrun_t *underruns)
+{
+  underruns->segment_underruns = st_segment_underruns;
+  underruns->planner_starved = st_planner_starved;
+  underruns->min_buffered_valid = (st_min_buffered_ticks != 0xFFFFFFFF);
+  underruns->min_buffered_ms = underruns->min_buffered_valid ? st_min_buffered_ticks/(SystemCoreClock/1000) : 0;
+}
+
+
+void st_reset_underruns()
+{
+  st_segment_underruns = 0;
+  st_planner_starved = 0;
+  st_min_buffered_ticks = 0xFFFFFFFF;
+}
+
+
+// Gets the Bresenham state of the segment being executed, as the last probe triggered.
+void st_get_probe_steps(probe_steps_t *steps)
+{
+  memcpy(steps,&st_probe,sizeof(probe_steps_t));
+}
@@ -26,6 +26,15 @@
   #define SEGMENT_BUFFER_SIZE 6
 #endif
 
+// Segment buffer and planner starvation counters, since power-up or the last '$UR' command. Tell
+// apart stalls caused by the step segment generation from those caused by the host or the parser.
+typedef struct {
+  uint32_t segment_underruns;  // Segment buffer ran empty during a cycle, with planned motion left.
+  uint32_t planner_starved;    // Planner ran empty during a cycle, while motion was still executing.
+  uint32_t min_buffered_ms;    // Least motion time left in the segment buffer, with planned motion left.
+  uint8_t min_buffered_valid;  // Set once the buffered motion time has been measured.
+} st_underrun_t;
+
 // Initialize and setup the stepper motor subsystem
 void stepper_init();
 
@@ -53,4 +62,17 @@ void st_update_plan_block_parameters();
 // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
 float st_get_realtime_rate();
 
+// Returns the estimated time of the motion queued in the segment and planner buffers in minutes.
+float st_get_queued_time();
+
+// Called by the planner, when a block is added to an empty planner during a cycle.
+void st_count_planner_starved();
+
+// Gets and resets the starvation counters. ($U, $UR)
+void st_get_underruns(st_underrun_t *underruns);
+void st_reset_underruns();
+
+// Gets the Bresenham state of the segment being executed, as the last probe triggered.
+void st_get_probe_steps(probe_steps_t *steps);
+
 #endif
@@ -162,6 +162,34 @@ uint8_t system_execute_line(char *line)
           break;
       }
       break;
+    #ifdef GC_LINE_CACHE_SIZE
+      case 'L' : // Prints g-code parser line cache counters
+        if ((line[2] != 'C') || (line[3] != 0)) { return(STATUS_INVALID_STATEMENT); }
+        report_line_cache_counters();
+        break;
+    #endif
+    case 'U' : // Prints or resets starvation counters
+      if (line[2] == 0) { report_underruns(); }
+      else if ((line[2] == 'R') && (line[3] == 0)) { st_reset_underruns(); }
+      else { return(STATUS_INVALID_STATEMENT); }
+      break;
+    #ifdef LASER_RASTER
+      case 'B' : // Raster scanline commands. Streamed like g-code.
+        if (sys.state & (STATE_ALARM | STATE_JOG)) { return(STATUS_SYSTEM_GC_LOCK); }
+        if (line[2] == '=') { return(raster_add_pixels(&line[3])); } // $B=<hex pixel powers>
+        if (((line[2] != 'X') && (line[2] != 'Y')) || (line[3] != '=')) { return(STATUS_INVALID_STATEMENT); }
+        char_counter = 4; // $BX=<pitch> or $BY=<pitch>
+        if (!read_float(line, &char_counter, &value)) { return(STATUS_BAD_NUMBER_FORMAT); }
+        if (line[char_counter] != 0) { return(STATUS_INVALID_STATEMENT); }
+        return(raster_execute((line[2] == 'X') ? X_AXIS : Y_AXIS, value));
+    #endif
+    #ifdef CPU_PROFILE
+      case 'T' : // Prints or resets profiler statistics
+        if (line[2] == 0) { report_profile(); }
+        else if ((line[2] == 'R') && (line[3] == 0)) { profile_reset(); }
+        else { return(STATUS_INVALID_STATEMENT); }
+        break;
+    #endif
     default :
       // Block any system command that requires the state as IDLE/ALARM. (i.e. EEPROM, homing)
       if ( !(sys.state == STATE_IDLE || sys.state == STATE_ALARM) ) { return(STATUS_IDLE_ERROR); }
@@ -195,6 +223,44 @@ uint8_t system_execute_line(char *line)
             if (line[2] == 0) { system_execute_startup(line); } // Execute startup script again.
           }
           break;
+        case 'F' : // Flush deferred settings writes to flash [IDLE/ALARM]
+          if ( line[2] != 0 ) { return(STATUS_INVALID_STATEMENT); }
+          settings_commit_deferred();
+          break;
+        case 'P' : // Stored program commands [IDLE/ALARM]
+          if ( line[2] == 0 ) { report_program_info(); }
+          else if ( line[3] != 0 ) { return(STATUS_INVALID_STATEMENT); }
+          else {
+            switch (line[2]) {
+              case 'W' : return(program_upload_begin()); // Start storing received lines
+              case 'E' : return(program_upload_end()); // End of stored lines
+              case 'R' : // Run stored program [IDLE Only] Prevents motion during ALARM.
+                if (sys.state != STATE_IDLE) { return(STATUS_IDLE_ERROR); }
+                return(program_execute(line));
+              default : return(STATUS_INVALID_STATEMENT);
+            }
+          }
+          break;
+        #ifdef HEIGHT_MAP
+          case 'Z' : // Height map commands [IDLE/ALARM]
+            if ( line[2] == 0 ) { report_heightmap(); }
+            else if ((line[2] == 'C') && (line[3] == 0)) {
+              heightmap_clear();
+              gc_sync_position();
+            } else if ((line[2] == 'P') && (line[3] == '=')) { // Probe height map [IDLE Only]
+              if (sys.state != STATE_IDLE) { return(STATUS_IDLE_ERROR); }
+              // $ZP=<x points>,<y points>,<x spacing>,<y spacing>,<depth>,<feed rate>
+              float values[6];
+              char_counter = 4;
+              for (helper_var=0; helper_var<6; helper_var++) {
+                if (helper_var && (line[char_counter++] != ',')) { return(STATUS_INVALID_STATEMENT); }
+                if (!read_float(line, &char_counter, &values[helper_var])) { return(STATUS_BAD_NUMBER_FORMAT); }
+              }
+              if ((line[char_counter] != 0) || (values[0] > 255) || (values[1] > 255)) { return(STATUS_INVALID_STATEMENT); }
+              return(heightmap_probe(trunc(values[0]), trunc(values[1]), values[2], values[3], values[4], values[5]));
+            } else { return(STATUS_INVALID_STATEMENT); }
+            break;
+        #endif
         case 'S' : // Puts Grbl to sleep [IDLE/ALARM]
           if ((line[2] != 'L') || (line[3] != 'P') || (line[4] != 0)) { return(STATUS_INVALID_STATEMENT); }
           system_set_exec_state_flag(EXEC_SLEEP); // Set to execute sleep mode immediately
@@ -274,15 +340,70 @@ uint8_t system_execute_line(char *line)
 
 
 
+#ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+  // Work coordinate offsets of the last generations, indexed by the generation modulo their count.
+  static float sys_wco[WCO_GENERATIONS][N_AXIS];
+  // The uint8_t generation wraps at 256. The slots stay in step across the wrap only if they divide it.
+  static_assert((WCO_GENERATIONS >= 2) && (WCO_GENERATIONS <= 128) &&
+    ((WCO_GENERATIONS & (WCO_GENERATIONS-1)) == 0), "WCO_GENERATIONS must be a power of two up to 128");
+#endif
+
+
+// Computes the work coordinate offset of the g-code parser state.
+static void system_get_gc_wco(float *wco)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    wco[idx] = gc_state.coord_system[idx]+gc_state.coord_offset[idx];
+    if (idx == TOOL_LENGTH_OFFSET_AXIS) { wco[idx] += gc_state.tool_length_offset; }
+  }
+}
+
+
 void system_flag_wco_change()
 {
   #ifdef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
     protocol_buffer_synchronize();
+  #else
+    // Wait for the oldest generation in the planner buffer to finish, if the new one would overwrite it.
+    plan_block_t *block = plan_get_current_block();
+    if (block != NULL) {
+      if ((uint8_t)(sys.wco_generation+1-block->wco_generation) >= WCO_GENERATIONS) { protocol_buffer_synchronize(); }
+    }
+    system_add_wco_generation();
   #endif
   sys.report_wco_counter = 0;
 }
 
 
+#ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+  void system_add_wco_generation()
+  {
+    sys.wco_generation++;
+    system_get_gc_wco(sys_wco[sys.wco_generation % WCO_GENERATIONS]);
+  }
+#endif
+
+
+// NOTE: The executing block is the first block in the planner buffer, like the reported line number.
+// Once the buffer is empty, the g-code parser offset is in effect.
+uint8_t system_get_wco(float *wco)
+{
+  #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+    plan_block_t *block = plan_get_current_block();
+    if (block != NULL) {
+      memcpy(wco,sys_wco[block->wco_generation % WCO_GENERATIONS],sizeof(sys_wco[0]));
+      return(block->wco_generation);
+    }
+    system_get_gc_wco(wco);
+    return(sys.wco_generation);
+  #else
+    system_get_gc_wco(wco);
+    return(0);
+  #endif
+}
+
+
 // Returns machine position of axis 'idx'. Must be sent a 'step' array.
 // NOTE: If motor steps and machine position are not in the same coordinate frame, this function
 //   serves as a central place to compute the transformation.
@@ -356,7 +477,7 @@ uint8_t system_check_travel_limits(float *target)
 // Special handlers for setting and clearing Grbl's real-time execution flags.
 // ARM: interrupts are always enabled, even within ISRs. We don't have
 // to check on entry.
-void system_set_exec_state_flag(uint8_t mask) {
+FASTCODE void system_set_exec_state_flag(uint8_t mask) { // Called by the stepper ISR. Kept in RAM.
   __disable_irq();
   sys_rt_exec_state |= (mask);
   __enable_irq();
@@ -137,11 +137,14 @@ typedef struct {
   uint8_t spindle_stop_ovr;    // Tracks spindle stop override states
   uint8_t report_ovr_counter;  // Tracks when to add override data to status reports.
   uint8_t report_wco_counter;  // Tracks when to add work coordinate offset data to status reports.
+  #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+    uint8_t wco_generation;    // Work coordinate offset generation of newly planned blocks.
+  #endif
   #ifdef ENABLE_PARKING_OVERRIDE_CONTROL
     uint8_t override_ctrl;     // Tracks override control states.
   #endif
   #ifdef VARIABLE_SPINDLE
-    float spindle_speed;
+    uint16_t spindle_level;    // PWM lookup table level of the spindle output. See spindle_get_speed().
   #endif
 } system_t;
 extern system_t sys;
@@ -177,8 +180,20 @@ uint8_t system_execute_line(char *line);
 void system_execute_startup(char *line);
 
 
+// Called upon a work coordinate offset change of the g-code parser. Flags the status report to
+// show the new offset and, if enabled, syncs the planner buffer.
 void system_flag_wco_change();
 
+#ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE
+  // Starts a new work coordinate offset generation with the offset of the g-code parser, which
+  // newly planned blocks are tagged with. Called by system_flag_wco_change() and gc_init().
+  void system_add_wco_generation();
+#endif
+
+// Gets the work coordinate offset in effect for the executing block, including the tool length offset.
+// Returns the generation of the offset, if enabled.
+uint8_t system_get_wco(float *wco);
+
 // Returns machine position of axis 'idx'. Must be sent a 'step' array.
 float system_convert_axis_steps_to_mpos(int32_t *steps, uint8_t idx);
 
@@ -0,0 +1,98 @@
+// Generated CAM program for the host benchmarks. A pocket of line and arc moves, as g-code lines the
+// way the protocol passes them to the parser: uppercase, with spaces and comments removed.
+
+#ifndef corpus_h
+#define corpus_h
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CORPUS_LINES 20000
+#define CORPUS_LINE_SIZE 80
+
+static char corpus[CORPUS_LINES][CORPUS_LINE_SIZE];
+static uint32_t corpus_words;
+
+// Appends a g-code word, formatted the way CAM post processors do: fixed decimals, with trailing zeros
+// and the decimal point of integers dropped.
+static void corpus_add_word(char *line, char letter, float value, int decimals)
+{
+  char word[32];
+  int length = snprintf(word,sizeof(word),"%c%.*f",letter,decimals,value);
+  if (decimals > 0) {
+    while (word[length-1] == '0') { length--; }
+    if (word[length-1] == '.') { length--; }
+  }
+  word[length] = 0;
+  if (strcmp(word+1,"-0") == 0) { strcpy(word+1,"0"); }
+  strcat(line,word);
+  corpus_words++;
+}
+
+// Generates the program: a header of modal commands, then passes of the pocket with line and arc
+// moves, stepping down in Z, with rapids between passes. Arc end points are on the arc to within the
+// rounding of the printed decimals.
+static void make_corpus()
+{
+  uint32_t n = 0;
+  const char *header[] = { "G90G94G17", "G21", "G54", "M3S12000", "F1500", "G0Z5.", "M8" };
+  for (const char *line : header) {
+    strcpy(corpus[n++],line);
+    for (const char *c = line; *c; c++) { if (*c >= 'A' && *c <= 'Z') { corpus_words++; } }
+  }
+
+  float x = 0, y = 0, z = 5, angle = 0;
+  uint8_t motion = 0;
+  srand(1);
+  while (n < CORPUS_LINES) {
+    char *line = corpus[n++];
+    line[0] = 0;
+    uint32_t kind = rand() % 100;
+    if (kind < 3) {
+      // Rapid to the next pass and plunge.
+      corpus_add_word(line,'G',0,0);
+      motion = 0;
+      x = (rand() % 200000) / 1000.0 - 100;
+      y = (rand() % 200000) / 1000.0 - 100;
+      corpus_add_word(line,'X',x,3);
+      corpus_add_word(line,'Y',y,3);
+      if (n < CORPUS_LINES) {
+        line = corpus[n++];
+        line[0] = 0;
+        z = -(rand() % 5000) / 1000.0;
+        corpus_add_word(line,'G',1,0);
+        motion = 1;
+        corpus_add_word(line,'Z',z,3);
+        corpus_add_word(line,'F',300,0);
+      }
+    } else if (kind < 20) {
+      // Arc move, with its center relative to the start point.
+      float i = (rand() % 20000) / 1000.0 - 10;
+      float j = (rand() % 20000) / 1000.0 - 10;
+      angle += 0.3;
+      x += i - hypot(i,j)*cos(angle);
+      y += j - hypot(i,j)*sin(angle);
+      motion = 2 + rand() % 2;
+      corpus_add_word(line,'G',motion,0);
+      corpus_add_word(line,'X',x,3);
+      corpus_add_word(line,'Y',y,3);
+      corpus_add_word(line,'I',i,3);
+      corpus_add_word(line,'J',j,3);
+    } else {
+      // Line move. G1 is omitted on most lines once modal, and the feed rate is only set now and then.
+      x += (rand() % 4000) / 1000.0 - 2;
+      y += (rand() % 4000) / 1000.0 - 2;
+      if ((kind < 30) || (motion != 1)) { corpus_add_word(line,'G',1,0); }
+      motion = 1;
+      corpus_add_word(line,'X',x,3);
+      corpus_add_word(line,'Y',y,3);
+      if (kind < 35) { corpus_add_word(line,'Z',z,3); }
+      if (kind < 25) { corpus_add_word(line,'F',1500,0); }
+    }
+  }
+}
+
+#endif
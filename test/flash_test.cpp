@@ -0,0 +1,307 @@
+// Host test of the settings log in grbl-lpc/flash.cpp.
+//
+// The flash is simulated in RAM, behind the IAP entry point. Faults are injected into the IAP commands:
+// either the power is lost midway through a command, or the command fails. Erasing and programming
+// stop partway at a fault. The image is checked after each simulated power-up.
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "test.h"
+
+// Stand-ins for the hardware and for grbl.h
+static char sim_flash[0x80000];
+#define FLASH_MEMORY(addr) ((const char *)sim_flash + (addr))
+static struct
+{
+    uint32_t ISER[8];
+    uint32_t ICER[8];
+} sim_nvic;
+#define NVIC (&sim_nvic)
+static constexpr unsigned TIMER1_IRQn = 2;
+static void __DSB() {}
+static void __ISB() {}
+static uint32_t SystemCoreClock = 100000000;
+#define PROGRAM_PAGE_SIZE 256
+#define grbl_h // Replaced by the stand-ins above
+
+#include "flash.cpp"
+
+struct PowerLoss
+{
+};
+
+static int sim_fault_at = -1;      // Number of IAP commands to run before the fault. -1 if none.
+static bool sim_fault_power_loss; // Power is lost at the fault. Otherwise the command fails.
+
+static unsigned sim_sector_addr(unsigned sector)
+{
+    return sector < 16 ? sector * 0x1000 : 0x10000 + (sector - 16) * 0x8000;
+}
+
+static void sim_iap(unsigned command[], unsigned output[])
+{
+    bool fault = sim_fault_at == 0;
+    if (sim_fault_at >= 0)
+        --sim_fault_at;
+    output[0] = 0; // CMD_SUCCESS
+    if (command[0] == 52)
+    {
+        // Erase sector(s). Stops partway at a fault.
+        unsigned begin = sim_sector_addr(command[1]);
+        unsigned size = sim_sector_addr(command[2] + 1) - begin;
+        memset(sim_flash + begin, 0xFF, fault ? rand() % size : size);
+    }
+    else if (command[0] == 51)
+    {
+        // Copy RAM to flash. Programming only clears bits. Stops partway at a fault.
+        auto source = (const char *)(uintptr_t)command[2];
+        unsigned size = fault ? rand() % command[3] : command[3];
+        for (unsigned i = 0; i < size; ++i)
+            sim_flash[command[1] + i] &= source[i];
+    }
+    if (fault)
+    {
+        if (sim_fault_power_loss)
+            throw PowerLoss();
+        output[0] = 11; // BUSY
+    }
+}
+
+// Clears the RAM state of flash.cpp and loads the image from the simulated flash.
+static void power_up()
+{
+    log_sector = log_sectors;
+    log_page = 0;
+    log_sequence = 0;
+    dirty_begin = flash_size;
+    dirty_end = 0;
+    log_snapshot_due = false;
+    memset(flash_buffer, 0, flash_size);
+    eeprom_init();
+}
+
+static void get_image(char *image)
+{
+    for (unsigned i = 0; i < flash_size; ++i)
+        image[i] = eeprom_get_char(i);
+}
+
+static bool image_is(const char *image)
+{
+    for (unsigned i = 0; i < flash_size; ++i)
+        if (eeprom_get_char(i) != (unsigned char)image[i])
+            return false;
+    return true;
+}
+
+// Changes a random range of the image, the way settings are stored. Mostly small, sometimes a few pages.
+static void change_image(char *image)
+{
+    char data[flash_size];
+    unsigned size = 1 + rand() % (rand() % 8 ? 32 : 800);
+    unsigned destination = rand() % (flash_size - size);
+    for (unsigned i = 0; i < size; ++i)
+        data[i] = rand();
+    if (size == 1)
+        eeprom_put_char(destination, data[0]);
+    else
+        memcpy_to_eeprom_with_checksum(destination, data, size - 1);
+    get_image(image);
+}
+
+static void reset_flash()
+{
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+    sim_fault_at = -1;
+}
+
+// Without a log, the whole-image store of older builds is imported. The first commit starts the log.
+static void test_legacy_import()
+{
+    char image[flash_size];
+    reset_flash();
+    for (unsigned i = 0; i < flash_size; ++i)
+        sim_flash[legacy_addr + i] = i * 7;
+    power_up();
+    for (unsigned i = 0; i < flash_size; ++i)
+        CHECK(eeprom_get_char(i) == (unsigned char)(i * 7));
+
+    change_image(image);
+    eeprom_commit();
+    memset(sim_flash + legacy_addr, 0xFF, log_sector_size);
+    power_up();
+    CHECK(image_is(image));
+}
+
+// Commits are replayed across sector changes, once the log wraps around many times.
+static void test_commits()
+{
+    char image[flash_size];
+    reset_flash();
+    power_up();
+    for (unsigned n = 0; n < 5000; ++n)
+    {
+        change_image(image);
+        eeprom_commit();
+        if (n % 7 == 0)
+        {
+            power_up();
+            CHECK(image_is(image));
+        }
+    }
+}
+
+// Power loss at any point of a commit recovers either the previous or the new image.
+static void test_power_loss()
+{
+    char committed[flash_size], image[flash_size];
+    unsigned lost = 0, kept = 0;
+    reset_flash();
+    power_up();
+    get_image(committed);
+    for (unsigned n = 0; n < 5000; ++n)
+    {
+        change_image(image);
+        sim_fault_at = rand() % 8;
+        sim_fault_power_loss = true;
+        try
+        {
+            eeprom_commit();
+        }
+        catch (PowerLoss &)
+        {
+        }
+        sim_fault_at = -1;
+        power_up();
+        if (image_is(image))
+        {
+            memcpy(committed, image, flash_size);
+            ++kept;
+        }
+        else
+        {
+            CHECK(image_is(committed));
+            ++lost;
+        }
+    }
+    CHECK(lost > 0 && kept > 0);
+}
+
+// A failed commit keeps its changes, which are written by the next commit.
+static void test_failures()
+{
+    char image[flash_size];
+    reset_flash();
+    power_up();
+    for (unsigned n = 0; n < 5000; ++n)
+    {
+        change_image(image);
+        sim_fault_at = rand() % 8;
+        sim_fault_power_loss = false;
+        eeprom_commit();
+        sim_fault_at = -1;
+        if (rand() % 2)
+            change_image(image);
+        eeprom_commit();
+        power_up();
+        CHECK(image_is(image));
+    }
+}
+
+// A failed erase of the next sector is retried, before anything is appended to it. The older sectors
+// are kept meanwhile.
+static void test_erase_failure()
+{
+    char image[flash_size];
+    reset_flash();
+    power_up();
+    for (unsigned n = 0; n < 3 * log_sectors; ++n)
+    {
+        change_image(image);
+        eeprom_commit();
+    }
+    unsigned sector = log_sector;
+    while (log_page < log_sector_pages)
+    {
+        eeprom_put_char(0, eeprom_get_char(0) + 1);
+        eeprom_commit();
+    }
+    for (unsigned n = 0; n < 2 * log_sectors; ++n)
+    {
+        eeprom_put_char(1, n);
+        get_image(image);
+        sim_fault_at = 1; // Erase command, after the prepare command
+        sim_fault_power_loss = false;
+        eeprom_commit();
+        CHECK(log_snapshot_due && log_sector == (sector + 1) % log_sectors);
+    }
+    sim_fault_at = -1;
+    eeprom_put_char(2, 0x55);
+    get_image(image);
+    eeprom_commit();
+    CHECK(!log_snapshot_due && log_sector == (sector + 1) % log_sectors);
+    power_up();
+    CHECK(image_is(image));
+}
+
+// Records stored with the checksum of older builds are still read. Storing them again writes the
+// rotating checksum.
+static void test_legacy_checksum()
+{
+    char data[40], read[sizeof(data)];
+    reset_flash();
+    power_up();
+    unsigned char checksum = 0;
+    for (unsigned i = 0; i < sizeof(data); ++i)
+    {
+        data[i] = rand();
+        eeprom_put_char(100 + i, data[i]);
+        checksum = (checksum != 0) + (unsigned char)data[i];
+    }
+    eeprom_put_char(100 + sizeof(data), checksum);
+    CHECK(memcpy_from_eeprom_with_checksum(read, 100, sizeof(data)));
+    CHECK(memcmp(read, data, sizeof(data)) == 0);
+    eeprom_put_char(100 + sizeof(data), checksum + 1);
+    CHECK(!memcpy_from_eeprom_with_checksum(read, 100, sizeof(data)));
+
+    memcpy_to_eeprom_with_checksum(100, data, sizeof(data));
+    CHECK(eeprom_get_char(100 + sizeof(data)) != checksum);
+    CHECK(memcpy_from_eeprom_with_checksum(read, 100, sizeof(data)));
+    CHECK(memcmp(read, data, sizeof(data)) == 0);
+}
+
+static void *run_tests(void *)
+{
+    CHECK((uintptr_t)flash_buffer <= UINT32_MAX);
+    iap = sim_iap;
+    srand(1);
+    test_legacy_import();
+    test_commits();
+    test_power_loss();
+    test_failures();
+    test_erase_failure();
+    test_legacy_checksum();
+    return nullptr;
+}
+
+int main()
+{
+    // flash_write passes RAM addresses to the IAP as 32-bit words, so the tests run on a stack below 4G.
+    size_t stack_size = 1 << 20;
+    void *stack = mmap(nullptr, stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    CHECK(stack != MAP_FAILED);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, stack_size);
+    pthread_t thread;
+    CHECK(pthread_create(&thread, &attr, run_tests, nullptr) == 0);
+    pthread_join(thread, nullptr);
+    printf("flash_test passed\n");
+    return 0;
+}
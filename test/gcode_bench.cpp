@@ -0,0 +1,166 @@
+// Host benchmark of the g-code parser in grbl/gcode.c.
+//
+// Each line of the generated CAM program of corpus.h is executed by gc_execute_line(), with the G and M
+// command lookup in gc_command_table and the lazy reset of the parser block. The motion, spindle and
+// coolant stand-ins do nothing, so the time per line is that of the parser. Reports nanoseconds and
+// host cycles per line, and the hits of the parsed line cache.
+//
+// NOTE: Host cycles are counted by the x86 time stamp counter, at its nominal rate. They are only a
+// relative measure for the parser on the LPC1769.
+
+#include <chrono>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+#endif
+
+#include "corpus.h"
+#include "test.h"
+
+// Stand-ins for grbl.h
+#include "config.h"
+#include "nuts_bolts.h"
+#include "planner.h"
+#include "coolant_control.h"
+#include "spindle_control.h"
+#include "gcode.h"
+#include "heightmap.h"
+#include "jog.h"
+#include "motion_control.h"
+#include "probe.h"
+#include "protocol.h"
+#include "report.h"
+
+#define PROFILE(section)
+
+#define BITFLAG_LASER_MODE bit(1)
+#define N_COORDINATE_SYSTEM 6
+#define SETTING_INDEX_G28 N_COORDINATE_SYSTEM
+#define SETTING_INDEX_G30 N_COORDINATE_SYSTEM+1
+#define EXEC_FEED_HOLD bit(3)
+#define STATE_CHECK_MODE bit(1)
+#define SUSPEND_RESTART_RETRACT bit(1)
+
+static struct {
+  uint8_t flags;
+} settings;
+
+static struct {
+  uint8_t state;
+  uint8_t abort;
+  uint8_t suspend;
+  uint8_t f_override;
+  uint8_t r_override;
+  uint8_t spindle_speed_ovr;
+} sys;
+
+static int32_t sys_position[N_AXIS];
+
+static uint32_t motions;
+
+uint8_t settings_read_coord_data(uint8_t coord_select, float *coord_data)
+{
+  clear_vector_float(coord_data);
+  return(true);
+}
+
+void settings_write_coord_data(uint8_t coord_select, float *coord_data, bool force, bool commit) {}
+void settings_commit_deferred() {}
+void system_add_wco_generation() {}
+void system_flag_wco_change() {}
+void system_set_exec_state_flag(uint8_t mask) {}
+
+void system_convert_array_steps_to_mpos(float *position, int32_t *steps)
+{
+  for (uint8_t idx=0; idx<N_AXIS; idx++) { position[idx] = 0; }
+}
+
+float heightmap_get_offset(float *position) { return(0.0); }
+void report_status_message(uint8_t status_code) {}
+void report_feedback_message(uint8_t message_code) {}
+void protocol_execute_realtime() {}
+void protocol_exec_rt_system() {}
+void delay_ms(uint32_t ms) {}
+void protocol_buffer_synchronize() {}
+void spindle_set_state(uint8_t state, float rpm) {}
+void spindle_sync(uint8_t state, float rpm) {}
+void coolant_set_state(uint8_t mode) {}
+void coolant_sync(uint8_t mode) {}
+void spindle_update_pwm_lut() {}
+void mc_update_accessories(plan_line_data_t *pl_data, uint8_t event) {}
+void mc_dwell(float seconds, plan_line_data_t *pl_data) {}
+void mc_canned_cycle(float *target, plan_line_data_t *pl_data, float *position, mc_canned_cycle_t *cycle) {}
+uint8_t mc_probe_cycle(float *target, plan_line_data_t *pl_data, uint8_t parser_flags) { return(GC_PROBE_FOUND); }
+uint8_t jog_execute(plan_line_data_t *pl_data, parser_block_t *gc_block) { return(STATUS_OK); }
+void mc_line(float *target, plan_line_data_t *pl_data) { motions++; }
+
+void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius,
+  uint8_t axis_0, uint8_t axis_1, uint8_t axis_linear, uint8_t is_clockwise_arc)
+{
+  motions++;
+}
+
+#define grbl_h // Replaced by the stand-ins above
+
+#include "gcode.c"
+#include "nuts_bolts.c"
+
+static inline uint64_t host_cycles()
+{
+  #if defined(__x86_64__) || defined(__i386__)
+    return(__rdtsc());
+  #else
+    return(0);
+  #endif
+}
+
+int main()
+{
+  make_corpus();
+  gc_init();
+
+  // Check that the whole program parses, once.
+  char line[CORPUS_LINE_SIZE];
+  for (uint32_t n = 0; n < CORPUS_LINES; n++) {
+    strcpy(line,corpus[n]);
+    uint8_t status = gc_execute_line(line);
+    if (status != STATUS_OK) { printf("%s: error %u\n",corpus[n],status); }
+    CHECK(status == STATUS_OK);
+  }
+  CHECK(motions > CORPUS_LINES-10);
+
+  // Best of a few runs over the program. The parser works on a copy of each line, as the protocol
+  // passes it from its line buffer.
+  double best_ns = 1e9, best_cycles = 1e9;
+  for (uint8_t run = 0; run < 5; run++) {
+    uint32_t lines = 0;
+    double seconds;
+    uint64_t cycles = host_cycles();
+    auto start = std::chrono::steady_clock::now();
+    do {
+      for (uint32_t n = 0; n < CORPUS_LINES; n++) {
+        strcpy(line,corpus[n]);
+        gc_execute_line(line);
+      }
+      lines += CORPUS_LINES;
+      seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < 0.2);
+    cycles = host_cycles() - cycles;
+    best_ns = fmin(best_ns,seconds*1e9/lines);
+    best_cycles = fmin(best_cycles,(double)cycles/lines);
+  }
+
+  printf("%u lines, %u words\n",CORPUS_LINES,corpus_words);
+  printf("gc_execute_line: %.0f ns/line, %.0f host cycles/line\n",best_ns,best_cycles);
+  #ifdef GC_LINE_CACHE_SIZE
+    uint32_t hits, misses;
+    gc_get_line_cache_counters(&hits,&misses);
+    printf("line cache: %u hits, %u misses\n",hits,misses);
+  #endif
+  return(0);
+}
@@ -0,0 +1,201 @@
+// Host benchmark of the g-code word parsing in grbl/nuts_bolts.c.
+//
+// Each word of the generated CAM program of corpus.h is parsed the way gc_execute_line() imports it:
+// by read_float() of Grbl 1.1f, with the command integer and mantissa taken from the float, and by
+// read_decimal(), with the command integer and mantissa split exactly and only value words converted
+// to float. Reports words/sec of both, and how many float values differ from the correctly rounded
+// strtof() value.
+//
+// NOTE: The host has a hardware FPU. On the LPC1769 (Cortex-M3), each float operation is a soft-float
+// library call, so the host understates the cost of the float math avoided by read_decimal().
+
+#include <chrono>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "corpus.h"
+#include "test.h"
+
+// Stand-ins for grbl.h
+#include "config.h"
+#include "nuts_bolts.h"
+
+#define SUSPEND_RESTART_RETRACT bit(1)
+
+static struct {
+  uint8_t abort;
+  uint8_t suspend;
+} sys;
+
+void protocol_execute_realtime() {}
+void protocol_exec_rt_system() {}
+void delay_ms(uint32_t ms) {}
+
+#define grbl_h // Replaced by the stand-ins above
+
+#include "nuts_bolts.c"
+
+// read_float() of Grbl 1.1f, before read_decimal(). Applies the decimal exponent with float multiplies.
+static uint8_t read_float_1_1f(char *line, uint8_t *char_counter, float *float_ptr)
+{
+  char *ptr = line + *char_counter;
+  unsigned char c;
+
+  c = *ptr++;
+  bool isnegative = false;
+  if (c == '-') {
+    isnegative = true;
+    c = *ptr++;
+  } else if (c == '+') {
+    c = *ptr++;
+  }
+
+  uint32_t intval = 0;
+  int8_t exp = 0;
+  uint8_t ndigit = 0;
+  bool isdecimal = false;
+  while(1) {
+    c -= '0';
+    if (c <= 9) {
+      ndigit++;
+      if (ndigit <= MAX_INT_DIGITS) {
+        if (isdecimal) { exp--; }
+        intval = (((intval << 2) + intval) << 1) + c; // intval*10 + c
+      } else {
+        if (!(isdecimal)) { exp++; }  // Drop overflow digits
+      }
+    } else if (c == (('.'-'0') & 0xff)  &&  !(isdecimal)) {
+      isdecimal = true;
+    } else {
+      break;
+    }
+    c = *ptr++;
+  }
+
+  if (!ndigit) { return(false); };
+
+  float fval;
+  fval = (float)intval;
+  if (fval != 0) {
+    while (exp <= -2) {
+      fval *= 0.01;
+      exp += 2;
+    }
+    if (exp < 0) {
+      fval *= 0.1;
+    } else if (exp > 0) {
+      do {
+        fval *= 10.0;
+      } while (--exp > 0);
+    }
+  }
+
+  if (isnegative) {
+    *float_ptr = -fval;
+  } else {
+    *float_ptr = fval;
+  }
+
+  *char_counter = ptr - line - 1;
+  return(true);
+}
+
+static volatile float sink;
+
+// Word import of Grbl 1.1f. Every word is converted to float, and the command integer and mantissa
+// of every word are taken from the float value.
+static void parse_1_1f(char *line, float *values)
+{
+  uint8_t char_counter = 0;
+  float value = 0;
+  float sum = 0;
+  while (line[char_counter] != 0) {
+    char letter = line[char_counter++];
+    read_float_1_1f(line,&char_counter,&value);
+    uint8_t int_value = trunc(value);
+    uint16_t mantissa = round(100*(value - int_value));
+    if ((letter == 'G') || (letter == 'M')) { sum += int_value + mantissa; }
+    else { sum += value; }
+    if (values) { *values++ = value; }
+  }
+  sink = sum;
+}
+
+// Word import of read_decimal(). The command integer and mantissa are split from the digits, and only
+// value words are converted to float.
+static void parse_decimal(char *line, float *values)
+{
+  uint8_t char_counter = 0;
+  int32_t significand;
+  int8_t exponent;
+  uint32_t int_part;
+  uint16_t mantissa;
+  float value;
+  float sum = 0;
+  while (line[char_counter] != 0) {
+    char letter = line[char_counter++];
+    read_decimal(line,&char_counter,&significand,&exponent);
+    if ((letter == 'G') || (letter == 'M')) {
+      decimal_split(significand,exponent,&int_part,&mantissa);
+      sum += int_part + mantissa;
+      if (values) { *values++ = int_part + mantissa/100.0; }
+    } else {
+      value = decimal_to_float(significand,exponent);
+      sum += value;
+      if (values) { *values++ = value; }
+    }
+  }
+  sink = sum;
+}
+
+// Counts the values of the corpus which differ from the correctly rounded value of their digits.
+static uint32_t count_inexact(void (*parse)(char *, float *))
+{
+  uint32_t inexact = 0;
+  for (uint32_t n = 0; n < CORPUS_LINES; n++) {
+    float values[16];
+    float *value = values;
+    parse(corpus[n],values);
+    for (char *c = corpus[n]; *c; ) {
+      char *end;
+      float expected = strtof(c+1,&end);
+      if (*value++ != expected) { inexact++; }
+      c = end;
+    }
+  }
+  return(inexact);
+}
+
+// Returns the best words/sec of a few runs over the corpus.
+static double words_per_sec(void (*parse)(char *, float *))
+{
+  double best = 0;
+  for (uint8_t run = 0; run < 5; run++) {
+    uint32_t passes = 0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds;
+    do {
+      for (uint32_t n = 0; n < CORPUS_LINES; n++) { parse(corpus[n],NULL); }
+      passes++;
+      seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < 0.2);
+    best = fmax(best,passes*(double)corpus_words/seconds);
+  }
+  return(best);
+}
+
+int main()
+{
+  make_corpus();
+  uint32_t inexact_1_1f = count_inexact(parse_1_1f);
+  uint32_t inexact_decimal = count_inexact(parse_decimal);
+  double rate_1_1f = words_per_sec(parse_1_1f);
+  double rate_decimal = words_per_sec(parse_decimal);
+  printf("%u lines, %u words\n",CORPUS_LINES,corpus_words);
+  printf("read_float (1.1f): %6.1f Mwords/s, %u inexact values\n",rate_1_1f/1e6,inexact_1_1f);
+  printf("read_decimal:      %6.1f Mwords/s, %u inexact values\n",rate_decimal/1e6,inexact_decimal);
+  return(0);
+}
@@ -0,0 +1,196 @@
+// Host test of the probe trigger interpolation in grbl/probe.c.
+//
+// The Bresenham line of the stepper ISR is simulated tick by tick, with AMASS-scaled counters and a
+// random AMASS level per segment. The probe edge is placed at a random point along the line and seen
+// at the start of the next ISR tick, where the ISR records its state. The position found by
+// probe_get_position() must be within the motion of a single ISR tick of the edge.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+
+// Stand-ins for grbl.h
+#define N_AXIS 3
+#include "nuts_bolts.h"
+#include "probe.h"
+
+#define EXEC_MOTION_CANCEL bit(6)
+#define MAX_AMASS_LEVEL 3 // As in stepper.c
+
+namespace board {
+    struct {
+        void init() {}
+        bool get() { return false; }
+    } probe;
+    bool leds[4];
+}
+
+static volatile uint8_t sys_probe_state;
+static volatile uint8_t sys_rt_exec_state;
+static int32_t sys_position[N_AXIS];
+static int32_t sys_probe_position[N_AXIS];
+static struct {
+    float steps_per_mm[N_AXIS];
+} settings;
+static probe_steps_t st_probe;
+
+static void system_convert_array_steps_to_mpos(float *position, int32_t *steps) {
+    for (uint8_t idx = 0; idx < N_AXIS; ++idx)
+        position[idx] = steps[idx] / settings.steps_per_mm[idx];
+}
+
+static void st_get_probe_steps(probe_steps_t *steps) {
+    memcpy(steps, &st_probe, sizeof(probe_steps_t));
+}
+
+#define grbl_h // Replaced by the stand-ins above
+
+#include "probe.c"
+
+// A planner block as the stepper ISR executes it. Steps per axis, with the direction bit set for
+// negative motion. Positions are in steps.
+struct Block {
+    uint32_t steps[N_AXIS];
+    uint8_t direction_bits;
+    int32_t start[N_AXIS];
+};
+
+// Result of a simulated probe cycle. Errors are the largest of all axes, in steps.
+struct Result {
+    bool triggered;
+    double error;          // Error of the interpolated trigger position
+    double excess;         // Error beyond the motion of the ISR ticks around the trigger
+    double whole_error;    // Error of the whole step position in sys_probe_position
+};
+
+// Runs the ISR over the block with random segments, until it sees the probe edge at fraction trigger
+// of the block. amass_level is the AMASS level of all segments, or random if negative.
+static Result simulate(const Block &block, double trigger, int amass_level) {
+    Result result = {};
+    uint32_t step_event_count = 0;
+    for (uint8_t idx = 0; idx < N_AXIS; ++idx)
+        if (block.steps[idx] > step_event_count)
+            step_event_count = block.steps[idx];
+
+    // Bresenham data, scaled by the maximum AMASS level as in st_prep_buffer().
+    uint32_t event_count = step_event_count << MAX_AMASS_LEVEL;
+    uint32_t counter[N_AXIS], steps[N_AXIS];
+    for (uint8_t idx = 0; idx < N_AXIS; ++idx) {
+        counter[idx] = event_count >> 1;
+        sys_position[idx] = block.start[idx];
+    }
+
+    double fraction = 0.0, previous_tick = 0.0;
+    while (fraction < 1.0) {
+        // Segment load. Each tick of the segment moves 2^-level of a step of the longest axis.
+        uint8_t level = amass_level < 0 ? rand() % (MAX_AMASS_LEVEL + 1) : amass_level;
+        for (uint8_t idx = 0; idx < N_AXIS; ++idx)
+            steps[idx] = (block.steps[idx] << MAX_AMASS_LEVEL) >> level;
+        double tick = 1.0 / (step_event_count << level);
+        for (unsigned n = 1 + rand() % 40; n && fraction < 1.0; --n) {
+            // Probe check at the start of the tick. The ISR records its state as the edge is seen.
+            if (fraction >= trigger) {
+                memcpy(sys_probe_position, sys_position, sizeof(sys_position));
+                for (uint8_t idx = 0; idx < N_AXIS; ++idx) {
+                    st_probe.counter[idx] = counter[idx];
+                    st_probe.steps[idx] = steps[idx];
+                }
+                st_probe.step_event_count = event_count;
+                st_probe.direction_bits = block.direction_bits;
+
+                // The edge is within the previous tick. The offset is taken from the current one.
+                float position[N_AXIS];
+                probe_get_position(position);
+                result.triggered = true;
+                for (uint8_t idx = 0; idx < N_AXIS; ++idx) {
+                    double sign = bit_istrue(block.direction_bits, bit(idx)) ? -1.0 : 1.0;
+                    double edge = block.start[idx] + sign * block.steps[idx] * trigger;
+                    double error = fabs(position[idx] * settings.steps_per_mm[idx] - edge);
+                    double whole_error = fabs(sys_probe_position[idx] - edge);
+                    double bound = block.steps[idx] *
+                        (tick == previous_tick ? 0.5 * tick : fmax(tick, previous_tick));
+                    result.error = fmax(result.error, error);
+                    result.excess = fmax(result.excess, error - bound);
+                    result.whole_error = fmax(result.whole_error, whole_error);
+                }
+                return result;
+            }
+
+            // Bresenham step, as in the ISR.
+            for (uint8_t idx = 0; idx < N_AXIS; ++idx) {
+                counter[idx] += steps[idx];
+                if (counter[idx] > event_count) {
+                    counter[idx] -= event_count;
+                    sys_position[idx] += bit_istrue(block.direction_bits, bit(idx)) ? -1 : 1;
+                }
+            }
+            fraction += tick;
+            previous_tick = tick;
+        }
+    }
+    return result;
+}
+
+static Block random_block() {
+    Block block;
+    block.direction_bits = 0;
+    for (uint8_t idx = 0; idx < N_AXIS; ++idx) {
+        block.steps[idx] = rand() % 4 ? rand() % 2000 : 0;
+        block.start[idx] = rand() % 20000 - 10000;
+        if (rand() % 2)
+            block.direction_bits |= bit(idx);
+    }
+    block.steps[rand() % N_AXIS] += 1;
+    return block;
+}
+
+// The trigger is found within the motion of an ISR tick, for any direction and AMASS level.
+static void test_random_blocks() {
+    unsigned triggered = 0;
+    for (unsigned n = 0; n < 20000; ++n) {
+        Block block = random_block();
+        Result result = simulate(block, rand() / (RAND_MAX + 1.0), -1);
+        if (!result.triggered)
+            continue;
+        CHECK(result.excess < 2e-3); // Float rounding of the position in mm
+        ++triggered;
+    }
+    CHECK(triggered > 19000);
+}
+
+// On a single slow axis, the interpolation resolves the trigger to a fraction of a step in either
+// direction. The whole step position is off by up to half a step.
+static void test_single_axis() {
+    double whole_error = 0.0;
+    for (uint8_t direction_bits = 0; direction_bits <= bit(Z_AXIS); direction_bits += bit(Z_AXIS)) {
+        Block block = {{0, 0, 10}, direction_bits, {0, 0, 100}};
+        for (unsigned n = 0; n < 1000; ++n) {
+            double trigger = 0.001 + n * 0.00098;
+            Result result = simulate(block, trigger, MAX_AMASS_LEVEL);
+            CHECK(result.triggered);
+            CHECK(result.error <= 0.5 / 8 + 1e-4);
+            whole_error = fmax(whole_error, result.whole_error);
+
+            float position[N_AXIS];
+            probe_get_position(position);
+            CHECK(position[X_AXIS] == 0.0 && position[Y_AXIS] == 0.0);
+            CHECK(direction_bits ? position[Z_AXIS] < 0.25 : position[Z_AXIS] > 0.25);
+        }
+    }
+    CHECK(whole_error > 0.45);
+}
+
+int main() {
+    settings.steps_per_mm[X_AXIS] = 80.0;
+    settings.steps_per_mm[Y_AXIS] = 80.0;
+    settings.steps_per_mm[Z_AXIS] = 400.0;
+    srand(1);
+    test_random_blocks();
+    test_single_axis();
+    printf("probe_test passed\n");
+    return 0;
+}
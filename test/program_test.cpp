@@ -0,0 +1,237 @@
+// Host test of the stored g-code programs in grbl/program.c.
+//
+// The program storage region is simulated in RAM. Like flash, it is erased to 0xFF and pages can only
+// be written once after an erase. Lines executed by the stored program are recorded in place of the
+// g-code parser.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+
+// Stand-ins for grbl.h
+#include "program.h"
+#include "protocol.h"
+#include "report.h"
+
+static struct {
+  uint8_t abort;
+} sys;
+
+static char sim_memory[16 * PROGRAM_PAGE_SIZE];
+static uint32_t sim_size = sizeof(sim_memory);
+static bool sim_written[sizeof(sim_memory) / PROGRAM_PAGE_SIZE];
+static int sim_fail_writes = -1;  // Number of page writes to run before one fails. -1 if none.
+
+uint32_t program_flash_size() { return(sim_size); }
+
+const char *program_flash_memory() { return(sim_memory); }
+
+uint8_t program_flash_erase()
+{
+  memset(sim_memory,0xFF,sizeof(sim_memory));
+  memset(sim_written,0,sizeof(sim_written));
+  return(true);
+}
+
+uint8_t program_flash_write(uint32_t offset, char *page)
+{
+  CHECK(offset % PROGRAM_PAGE_SIZE == 0 && offset+PROGRAM_PAGE_SIZE <= sim_size);
+  CHECK(!sim_written[offset/PROGRAM_PAGE_SIZE]);
+  if (sim_fail_writes >= 0 && sim_fail_writes-- == 0) { return(false); }
+  sim_written[offset/PROGRAM_PAGE_SIZE] = true;
+  memcpy(sim_memory+offset,page,PROGRAM_PAGE_SIZE);
+  return(true);
+}
+
+static char executed[400][LINE_BUFFER_SIZE];
+static uint32_t executed_lines;
+static uint32_t error_line;      // Line number to fail in the g-code parser. 0 if none.
+static uint32_t abort_line;      // Line number to abort at. 0 if none.
+static uint32_t reported_line;
+
+void protocol_execute_realtime()
+{
+  if (executed_lines+1 == abort_line) { sys.abort = true; }
+}
+
+uint8_t gc_execute_line(char *line)
+{
+  strcpy(executed[executed_lines++],line);
+  if (executed_lines == error_line) { return(STATUS_GCODE_UNSUPPORTED_COMMAND); }
+  return(STATUS_OK);
+}
+
+void report_program_line(uint32_t n, char *line)
+{
+  CHECK(strcmp(line,executed[n-1]) == 0);
+  reported_line = n;
+}
+
+#define grbl_h // Replaced by the stand-ins above
+
+#include "program.c"
+
+static void make_line(char *line, uint32_t n)
+{
+  // Lines of different lengths, so they cross page boundaries at different offsets.
+  sprintf(line,"G1X%uY%uF%u",n,n*37%1000,100+n%7*1000);
+}
+
+static void reset_execution()
+{
+  sys.abort = false;
+  executed_lines = 0;
+  error_line = 0;
+  abort_line = 0;
+  reported_line = 0;
+}
+
+// Uploads a program of the given number of lines and completes it.
+static void upload(uint32_t lines)
+{
+  char line[LINE_BUFFER_SIZE];
+  CHECK(program_upload_begin() == STATUS_OK);
+  CHECK(program_is_uploading());
+  for (uint32_t n = 1; n <= lines; n++) {
+    make_line(line,n);
+    CHECK(program_upload_line(line) == STATUS_OK);
+  }
+  CHECK(program_upload_end() == STATUS_OK);
+  CHECK(!program_is_uploading());
+}
+
+// A stored program executes its lines in order.
+static void test_execute()
+{
+  char line[LINE_BUFFER_SIZE];
+  uint32_t lines, size;
+  uint32_t counts[] = { 0, 1, 12, 13, 200 };
+  for (uint32_t count : counts) {
+    upload(count);
+    CHECK(program_get_info(&lines,&size));
+    uint32_t expected_size = 0;
+    for (uint32_t n = 1; n <= count; n++) { make_line(line,n); expected_size += strlen(line)+1; }
+    CHECK(lines == count && size == expected_size);
+
+    reset_execution();
+    CHECK(program_execute(line) == STATUS_OK);
+    CHECK(executed_lines == count);
+    char expected[LINE_BUFFER_SIZE];
+    for (uint32_t n = 1; n <= count; n++) { make_line(expected,n); CHECK(strcmp(executed[n-1],expected) == 0); }
+    CHECK(reported_line == 0);
+  }
+}
+
+// Only a completed upload stores a program. A reset mid-upload leaves no valid program.
+static void test_incomplete_upload()
+{
+  char line[LINE_BUFFER_SIZE];
+  uint32_t lines, size;
+  upload(20);
+  CHECK(program_upload_begin() == STATUS_OK);
+  CHECK(!program_get_info(&lines,&size)); // Erased by the new upload.
+  for (uint32_t n = 1; n <= 50; n++) { make_line(line,n); CHECK(program_upload_line(line) == STATUS_OK); }
+  CHECK(!program_get_info(&lines,&size));
+
+  program_init(); // System abort
+  CHECK(!program_is_uploading());
+  CHECK(program_upload_end() == STATUS_PROGRAM_INVALID);
+  CHECK(!program_get_info(&lines,&size));
+  reset_execution();
+  CHECK(program_execute(line) == STATUS_PROGRAM_INVALID);
+  CHECK(executed_lines == 0);
+}
+
+// A corrupted program is rejected by its checksum.
+static void test_corruption()
+{
+  char line[LINE_BUFFER_SIZE];
+  uint32_t lines, size;
+  upload(30);
+  CHECK(program_get_info(&lines,&size));
+  sim_memory[PROGRAM_PAGE_SIZE+size/2] ^= 0x04;
+  CHECK(!program_get_info(&lines,&size));
+  reset_execution();
+  CHECK(program_execute(line) == STATUS_PROGRAM_INVALID);
+  CHECK(executed_lines == 0);
+}
+
+// Lines past the end of the region are refused. The lines stored up to then still make a program.
+static void test_storage_full()
+{
+  char line[LINE_BUFFER_SIZE];
+  uint32_t lines, size, stored = 0, stored_size = 0;
+  CHECK(program_upload_begin() == STATUS_OK);
+  for (uint32_t n = 1; ; n++) {
+    make_line(line,n);
+    uint8_t status = program_upload_line(line);
+    if (status == STATUS_PROGRAM_STORAGE_FULL) { break; }
+    CHECK(status == STATUS_OK);
+    stored++;
+    stored_size += strlen(line)+1;
+  }
+  CHECK(stored_size+strlen(line)+1 > sim_size-PROGRAM_PAGE_SIZE);
+  CHECK(program_is_uploading());
+  CHECK(program_upload_end() == STATUS_OK);
+  CHECK(program_get_info(&lines,&size));
+  CHECK(lines == stored && size == stored_size);
+  reset_execution();
+  CHECK(program_execute(line) == STATUS_OK);
+  CHECK(executed_lines == stored);
+}
+
+// A failed flash write ends the upload. No program is stored.
+static void test_flash_failure()
+{
+  char line[LINE_BUFFER_SIZE];
+  uint32_t lines, size;
+  CHECK(program_upload_begin() == STATUS_OK);
+  sim_fail_writes = 1;
+  uint8_t status = STATUS_OK;
+  for (uint32_t n = 1; status == STATUS_OK; n++) {
+    make_line(line,n);
+    status = program_upload_line(line);
+  }
+  sim_fail_writes = -1;
+  CHECK(status == STATUS_PROGRAM_FLASH_FAIL);
+  CHECK(!program_is_uploading());
+  CHECK(program_upload_end() == STATUS_PROGRAM_INVALID);
+  CHECK(!program_get_info(&lines,&size));
+}
+
+// Execution stops at the first line with an error, which is reported with its line number.
+static void test_line_error()
+{
+  char line[LINE_BUFFER_SIZE];
+  upload(40);
+  reset_execution();
+  error_line = 25;
+  CHECK(program_execute(line) == STATUS_GCODE_UNSUPPORTED_COMMAND);
+  CHECK(executed_lines == 25 && reported_line == 25);
+}
+
+// A system abort stops execution before the next line.
+static void test_abort()
+{
+  char line[LINE_BUFFER_SIZE];
+  upload(40);
+  reset_execution();
+  abort_line = 10;
+  CHECK(program_execute(line) == STATUS_OK);
+  CHECK(executed_lines == 9 && reported_line == 0);
+}
+
+int main()
+{
+  test_execute();
+  test_incomplete_upload();
+  test_corruption();
+  test_storage_full();
+  test_flash_failure();
+  test_line_error();
+  test_abort();
+  printf("program_test passed\n");
+  return(0);
+}
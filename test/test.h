@@ -0,0 +1,19 @@
+// Checks for the host tests. A failed check reports its location and ends the test.
+
+#ifndef test_h
+#define test_h
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(condition)                                                            \
+    do                                                                              \
+    {                                                                               \
+        if (!(condition))                                                           \
+        {                                                                           \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);    \
+            exit(1);                                                                \
+        }                                                                           \
+    } while (0)
+
+#endif